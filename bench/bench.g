@@ -0,0 +1,137 @@
+#
+# debugger: Debugging support for GAP
+#
+# Measures how much the debugger's hooks slow down GAP code. Each workload
+# in bench/workloads.g is run under each configuration, and the results
+# printed as one JSON object per line, giving the total time and the
+# nanoseconds per statement and per function call. Run with 'make bench'.
+#
+LoadPackage( "debugger" );
+SetPrintFormattingStatus("*stdout*", false);
+
+BenchDir := DirectoriesPackageLibrary( "debugger", "bench" )[1];
+BenchWorkloadFile := Filename(BenchDir, "workloads.g");
+Read(BenchWorkloadFile);
+BenchMakeFiles(DirectoryTemporary(), 100);
+
+# How many times each workload is run. Each is timed BenchRepeats times,
+# and the fastest time is reported.
+BenchRepeats := 3;
+
+BenchWorkloads := [
+	rec(name := "loop", run := function() BenchLoop(1000000); end),
+	rec(name := "recursion", run := function() BenchRecursion(200); end),
+	rec(name := "calls", run := function() BenchCalls(300000); end),
+	rec(name := "manyfiles", run := function() BenchManyFiles(3000); end),
+];
+
+# Breakpoints which are never hit: one on each "never runs" line of the
+# workloads, and the rest on lines after the code in the generated files.
+BenchBreakpoints := function(count)
+	local lines, list, i;
+	lines := SplitString(StringFile(BenchWorkloadFile), "\n");
+	list := [];
+	for i in [1..Length(lines)] do
+		if PositionSublist(lines[i], "never runs") <> fail then
+			Add(list, [BenchWorkloadFile, i, function() end]);
+		fi;
+	od;
+	i := 0;
+	while Length(list) < count do
+		Add(list, [Concatenation("benchfile", String(i mod 100 + 1), ".g"),
+		           10 + QuoInt(i, 100), function() end]);
+		i := i + 1;
+	od;
+	AddBreakpoints(list{[1..count]});
+end;
+
+BenchConfigs := [
+	rec(name := "none", setup := function() end),
+	rec(name := "hooks", setup := ACTIVATE_DEBUGGING),
+	rec(name := "breakpoints10", setup := function() BenchBreakpoints(10); end),
+	rec(name := "breakpoints1000", setup := function() BenchBreakpoints(1000); end),
+	rec(name := "breakpoints100000", setup := function() BenchBreakpoints(100000); end),
+	rec(name := "everyline", setup := function()
+		BreakEveryLine(function(file, line) end);
+	end),
+	rec(name := "enterleave", setup := function()
+		BreakEveryEnterFunction(function(func) end);
+		BreakEveryLeaveFunction(function(func) end);
+	end),
+];
+
+BenchReset := function()
+	ClearAllBreakpoints();
+	BreakEveryLine(fail);
+	BreakEveryEnterFunction(fail);
+	BreakEveryLeaveFunction(fail);
+	DEACTIVATE_DEBUGGING();
+end;
+
+# Count the statements and function calls a workload runs, using the
+# line and function profilers
+BenchCount := function(workload)
+	local statements, calls;
+	BenchReset();
+	ClearLineProfile();
+	ClearFunctionProfile();
+	StartLineProfile();
+	StartFunctionProfile();
+	workload.run();
+	StopFunctionProfile();
+	StopLineProfile();
+	statements := Sum(LineProfile().hits);
+	calls := Sum(FunctionProfile(), r -> r.calls);
+	ClearLineProfile();
+	ClearFunctionProfile();
+	return rec(statements := statements, calls := calls);
+end;
+
+BenchTime := function(workload)
+	local best, start, time, i;
+	best := infinity;
+	for i in [1..BenchRepeats] do
+		start := NanosecondsSinceEpoch();
+		workload.run();
+		time := NanosecondsSinceEpoch() - start;
+		best := Minimum(best, time);
+	od;
+	return best;
+end;
+
+# 'num / den' as a decimal string with two places
+BenchDecimal := function(num, den)
+	local hundredths, frac;
+	if den = 0 then
+		return "null";
+	fi;
+	hundredths := QuoInt(100 * num + QuoInt(den, 2), den);
+	frac := String(RemInt(hundredths, 100));
+	if Length(frac) = 1 then
+		frac := Concatenation("0", frac);
+	fi;
+	return Concatenation(String(QuoInt(hundredths, 100)), ".", frac);
+end;
+
+BenchRun := function()
+	local workload, config, counts, time;
+	for workload in BenchWorkloads do
+		counts := BenchCount(workload);
+		for config in BenchConfigs do
+			BenchReset();
+			config.setup();
+			time := BenchTime(workload);
+			BenchReset();
+			Print("{\"workload\": \"", workload.name, "\", ",
+			      "\"config\": \"", config.name, "\", ",
+			      "\"statements\": ", counts.statements, ", ",
+			      "\"calls\": ", counts.calls, ", ",
+			      "\"ns\": ", time, ", ",
+			      "\"ns_per_statement\": ", BenchDecimal(time, counts.statements), ", ",
+			      "\"ns_per_call\": ", BenchDecimal(time, counts.calls), "}\n");
+		od;
+	od;
+end;
+
+BenchRun();
+QUIT_GAP(0);
@@ -0,0 +1,84 @@
+#
+# debugger: Debugging support for GAP
+#
+# Workloads for bench/bench.g. Lines marked "never runs" are used as the
+# locations of breakpoints which are never hit, so the cost of checking
+# breakpoints inside running functions is measured.
+#
+
+# A tight arithmetic loop
+BenchLoop := function(n)
+    local i, x;
+    x := 0;
+    for i in [1..n] do
+        x := x + i;
+        if x < 0 then
+            x := 0; # never runs
+        fi;
+    od;
+    return x;
+end;
+
+# Deep recursion
+BenchRecurse := function(depth)
+    if depth = 0 then
+        return 0;
+    fi;
+    if depth < 0 then
+        return -1; # never runs
+    fi;
+    return 1 + BenchRecurse(depth - 1);
+end;
+
+BenchRecursion := function(n)
+    local i, x;
+    x := 0;
+    for i in [1..n] do
+        x := x + BenchRecurse(1000);
+    od;
+    return x;
+end;
+
+# Many calls of a small function
+BenchSmall := function(x, i)
+    if i < 0 then
+        return 0; # never runs
+    fi;
+    return x + i;
+end;
+
+BenchCalls := function(n)
+    local i, x;
+    x := 0;
+    for i in [1..n] do
+        x := BenchSmall(x, i);
+    od;
+    return x;
+end;
+
+# Small functions, each in its own file, made by BenchMakeFiles
+BenchFileFunctions := [];
+
+BenchMakeFiles := function(dir, count)
+    local k, name;
+    for k in [1..count] do
+        name := Filename(dir, Concatenation("benchfile", String(k), ".g"));
+        PrintTo(name, "BenchFileFunctions[", k, "] := function(x)\n",
+                "    local y;\n",
+                "    y := x + ", k, ";\n",
+                "    return y;\n",
+                "end;\n");
+        Read(name);
+    od;
+end;
+
+BenchManyFiles := function(n)
+    local i, x, func;
+    x := 0;
+    for i in [1..n] do
+        for func in BenchFileFunctions do
+            x := func(x);
+        od;
+    od;
+    return x;
+end;
@@ -7,23 +7,125 @@
 #!
 #! @Section Function Descriptions
 
-#! @Arguments file, line [ , function]
+#! @Arguments file, line [ , function] [, options]
 #! @Description
 #!   Adds a breakpoint to all loaded files whose name
 #!   ends <A>file</A>, at line <A>line</A>.
+#!   If no such file has been read yet, the breakpoint is <E>pending</E>,
+#!   and is added to the matching files read in the meantime as soon as
+#!   code from one of them runs. This allows breakpoints to be set before
+#!   calling <C>LoadPackage</C>.
 #!   Optionally a <A>function</A> to call can be given.
 #!   The default function enters the break loop.
+#!   <P/>
+#!   <A>options</A> is a record, which limits when the breakpoint fires.
+#!   These conditions are checked without running any &GAP; code, so
+#!   reaching a breakpoint which does not fire is cheap.
+#!   The components are:
+#!   <List>
+#!   <Mark><C>ignore</C></Mark>
+#!   <Item>Do not fire the first <C>ignore</C> times the line is reached.</Item>
+#!   <Mark><C>every</C></Mark>
+#!   <Item>After that, only fire every <C>every</C>th time the line
+#!    is reached.</Item>
+#!   <Mark><C>variable</C></Mark>
+#!   <Item>The name of a local variable of the current function or, if
+#!    there is no such local, a global variable. The breakpoint
+#!    only fires if the variable is a small integer which is equal to
+#!    the component <C>equals</C>, or at least the component
+#!    <C>atLeast</C> (exactly one of these must be given).</Item>
+#!   <Mark><C>capture</C></Mark>
+#!   <Item>A list of names of variables, found as for <C>variable</C>.
+#!    When this is given, the breakpoint does not stop or call a function
+#!    when it fires. Instead the values of these variables are recorded,
+#!    to be read with <Ref Func="BreakpointHistory"/>.</Item>
+#!   <Mark><C>history</C></Mark>
+#!   <Item>With <C>capture</C>, the number of firings to keep
+#!    (default 100, at most 524288). Once this many are recorded, each
+#!    firing replaces the oldest.</Item>
+#!   <Mark><C>copy</C></Mark>
+#!   <Item>With <C>capture</C>, how values are recorded. The default,
+#!    <C>"shallow"</C>, records a shallow copy of mutable values, so the
+#!    history shows how a list or record changes. <C>"reference"</C>
+#!    records values without copying them, and <C>"summary"</C> records
+#!    only the type and size of values which are not small integers,
+#!    booleans or characters. Mutable values using more than
+#!    <C>copyLimit</C> bytes (default 65536) are always summarised.
+#!    Values are also summarised once all histories together hold 64MB of
+#!    values, copied or not, so histories never use more than a fixed
+#!    amount of memory.</Item>
+#!   </List>
 DeclareGlobalFunction( "AddBreakpoint" );
 
 #! @Arguments file, line
 #! @Description
 #!   Remove all breakpoints in loaded files whose name
-#!   ends <A>file</A> which occur at line <A>line</A>.
+#!   ends <A>file</A> which occur at line <A>line</A>, and any
+#!   pending breakpoint added with the same <A>file</A> and <A>line</A>.
 DeclareGlobalFunction( "ClearBreakpoint" );
 
+#! @Arguments list
+#! @Description
+#!   Adds many breakpoints at once. Each entry of <A>list</A> is a list
+#!   <C>[file, line]</C>, optionally followed by a function and an options
+#!   record, which mean the same as for <Ref Func="AddBreakpoint"/>.
+#!   Nothing is printed, and the breakpoints are added in a single pass,
+#!   which is much faster than calling <Ref Func="AddBreakpoint"/> for
+#!   each one.
+DeclareGlobalFunction( "AddBreakpoints" );
+
+#! @Arguments list
+#! @Description
+#!   Removes the breakpoints at all the locations in <A>list</A>, each
+#!   given as a list <C>[file, line]</C> as for
+#!   <Ref Func="ClearBreakpoint"/>, in a single pass.
+#!   Returns the number of breakpoints removed.
+DeclareGlobalFunction( "ClearBreakpoints" );
+
+#! @Arguments filename
+#! @Description
+#!   Saves the locations and options of all breakpoints (including
+#!   pending ones, and the <C>capture</C>, <C>history</C>, <C>copy</C> and
+#!   <C>copyLimit</C> options of breakpoints which record a history) to the
+#!   file <A>filename</A>. Files are stored by their path, so breakpoints can
+#!   be loaded in a later &GAP; session. The functions of breakpoints and
+#!   the recorded histories are not saved.
+#!   Returns the number of breakpoints saved.
+DeclareGlobalFunction( "SaveBreakpoints" );
+
+#! @Arguments filename [, function]
+#! @Description
+#!   Adds the breakpoints saved in <A>filename</A> by
+#!   <Ref Func="SaveBreakpoints"/>, calling <A>function</A> when they are
+#!   reached, or entering the break loop by default.
+#!   Returns the number of breakpoints loaded.
+DeclareGlobalFunction( "LoadBreakpoints" );
+
+#! @Arguments func [, function]
+#! @Description
+#!   Adds a breakpoint which triggers whenever the function <A>func</A>
+#!   is called. <A>function</A> is called with <A>func</A> as its only
+#!   argument, and by default enters the break loop.
+#!   Unlike filtering calls with <Ref Func="BreakEveryEnterFunction"/>,
+#!   no &GAP; code is run when other functions are called.
+#!   Adding a second breakpoint on <A>func</A> replaces the first.
+DeclareGlobalFunction( "AddFunctionBreakpoint" );
+
+#! @Arguments func
+#! @Description
+#!   Remove the breakpoint on calling <A>func</A>. Returns <K>true</K> if
+#!   there was such a breakpoint, and <K>false</K> otherwise.
+DeclareGlobalFunction( "ClearFunctionBreakpoint" );
+
 #! @Arguments
 #! @Description
-#!   Remove all breakpoints
+#!   Returns the list of functions which have breakpoints added by
+#!   <Ref Func="AddFunctionBreakpoint"/>.
+DeclareGlobalFunction( "ListFunctionBreakpoints" );
+
+#! @Arguments
+#! @Description
+#!   Remove all breakpoints, including those on functions
 DeclareGlobalFunction( "ClearAllBreakpoints" );
 
 #! @Arguments
@@ -33,6 +135,78 @@ DeclareGlobalFunction( "ClearAllBreakpoints" );
 #!   called.
 DeclareGlobalFunction( "ListBreakpoints" );
 
+#! @Arguments
+#! @Description
+#!   List the breakpoints on files which have not been read yet, as
+#!   pairs of the file and line given to <Ref Func="AddBreakpoint"/>.
+DeclareGlobalFunction( "ListPendingBreakpoints" );
+
+#! @Arguments
+#! @Description
+#!   Returns a list of triples, consisting of the file, line,
+#!   and the number of times the line of each breakpoint
+#!   has been reached (whether or not the breakpoint fired).
+DeclareGlobalFunction( "BreakpointHitCounts" );
+
+#! @Arguments file, line
+#! @Description
+#!   Returns the values recorded by breakpoints with the <C>capture</C>
+#!   option (see <Ref Func="AddBreakpoint"/>) in loaded files whose name
+#!   ends <A>file</A>, at line <A>line</A>, oldest first. Each is a record
+#!   with components <C>hit</C>, the number of times the line had been
+#!   reached, and <C>values</C>, a record of the captured variables
+#!   (variables which were unbound are left out). A history is discarded
+#!   when its breakpoint is removed.
+DeclareGlobalFunction( "BreakpointHistory" );
+
+#! @Arguments filename, line, template
+#! @Description
+#!   Add a logpoint to line <A>line</A> of every file whose name ends
+#!   with <A>filename</A>. Each time the line is reached, a message is
+#!   logged (once, however many statements are on the line) and execution
+#!   continues. The message is <A>template</A>, with
+#!   each <C>{name}</C> replaced by the value of the local variable (or if
+#!   there is none, global variable) <C>name</C>. Use <C>{{</C> and
+#!   <C>}}</C> for braces.
+#!
+#!   When a logpoint is reached only the values are recorded; messages are
+#!   made and written out a batch at a time, by
+#!   <Ref Func="FlushLogpoints"/> or when the batch is full. Mutable values
+#!   are shallow copied when the logpoint is reached, so messages show them
+#!   as they were then, except that values using more than 65536 bytes are
+#!   only shown by their type and size.
+DeclareGlobalFunction( "AddLogpoint" );
+
+#! @Arguments
+#! @Description
+#!   Remove all logpoints. Messages already recorded are kept.
+DeclareGlobalFunction( "ClearLogpoints" );
+
+#! @Arguments
+#! @Description
+#!   List all logpoints, as pairs of the fileid and line.
+DeclareGlobalFunction( "ListLogpoints" );
+
+#! @Arguments filename
+#! @Description
+#!   Write logpoint messages to <A>filename</A>, one per line, rather than
+#!   keeping them for <Ref Func="DrainLogpoints"/>. Passing <K>fail</K>
+#!   closes the file, and goes back to keeping messages.
+DeclareGlobalFunction( "SetLogpointFile" );
+
+#! @Arguments
+#! @Description
+#!   Make messages for every logpoint reached so far, and write them to the
+#!   file given to <Ref Func="SetLogpointFile"/> if there is one. Returns
+#!   the number of messages.
+DeclareGlobalFunction( "FlushLogpoints" );
+
+#! @Arguments
+#! @Description
+#!   Returns the list of logpoint messages not yet returned, when no file
+#!   has been given to <Ref Func="SetLogpointFile"/>.
+DeclareGlobalFunction( "DrainLogpoints" );
+
 #! @Arguments [function]
 #! @Description
 #!   Triggers <A>function</A> next time a new line of code
@@ -44,6 +218,37 @@ DeclareGlobalFunction( "ListBreakpoints" );
 #!   <A>function</A>, if defined, should accept no arguments.
 DeclareGlobalFunction( "BreakNextLine" );
 
+#! @Arguments [function]
+#! @Description
+#!   Triggers <A>function</A> when execution reaches a new line in the
+#!   current function, or returns to the function which called it. The
+#!   current function is the one the debugger last stopped in, so this can
+#!   be called from the break loop of a breakpoint.
+#!   Lines run inside functions called from the current line are skipped.
+#!   By default, <A>function</A> will enter the break loop.
+#!
+#!   While stepping, each new line only checks which function is running,
+#!   so no &GAP; code runs until <A>function</A> is called. Stepping is cancelled by
+#!   passing <B>fail</B>, or when an error occurs.
+#!
+#!   <A>function</A>, if defined, should accept two arguments, the fileid
+#!   and line number, as for <Ref Func="BreakEveryLine"/>.
+DeclareGlobalFunction( "StepOver" );
+
+#! @Arguments [function]
+#! @Description
+#!   Triggers <A>function</A> on the first line run after the current
+#!   function returns. Otherwise, this behaves like <Ref Func="StepOver"/>.
+DeclareGlobalFunction( "StepOut" );
+
+#! @Arguments n[, function]
+#! @Description
+#!   Triggers <A>function</A> when the <A>n</A>th new line of code,
+#!   in any function, begins execution. <C>StepLines(1)</C> behaves like
+#!   <Ref Func="BreakNextLine"/>, except that <A>function</A> is given the
+#!   fileid and line number, as for <Ref Func="StepOver"/>.
+DeclareGlobalFunction( "StepLines" );
+
 #! @Arguments [function]
 #! @Description
 #!   Triggers <A>function</A> every time a new line of code
@@ -102,9 +307,456 @@ DeclareGlobalFunction( "BreakNextLeaveFunction" );
 DeclareGlobalFunction( "BreakEveryLeaveFunction" );
 
 
+#! @Arguments name [, function]
+#! @Description
+#!   Watch the global variable called <A>name</A>. Whenever its value
+#!   changes, <A>function</A> is called, by default entering the break loop.
+#!   Plain lists, records and strings are also checked for being changed
+#!   in place, by comparing the identity of (at most 256 of) their entries.
+#!   The check is made after every statement, without running any &GAP;
+#!   code unless a value has changed.
+#!   <P/>
+#!   <A>function</A> should accept five arguments: the name of the
+#!   variable, its old and new values (<K>fail</K> if unbound), and the
+#!   file id and line of the statement which changed it (as for
+#!   <Ref Func="BreakEveryLine"/>). When a list or record is changed in
+#!   place, the old and new values are the same object.
+DeclareGlobalFunction( "WatchGlobal" );
+
+#! @Arguments name
+#! @Description
+#!   Stop watching the global variable called <A>name</A>. Returns
+#!   <K>true</K> if it was being watched, and <K>false</K> otherwise.
+DeclareGlobalFunction( "UnwatchGlobal" );
+
+#! @Arguments
+#! @Description
+#!   Returns the names of the global variables being watched.
+DeclareGlobalFunction( "WatchedGlobals" );
+
+#! @Arguments bytes[, callback]
+#! @Description
+#!   Calls <A>callback</A> once the &GAP; heap has grown by more than
+#!   <A>bytes</A> since <C>BreakOnHeapGrowth</C> was called, so the limit
+#!   is on growth from that moment, not on the total size of the heap. By
+#!   default, the functions running are printed and the break loop is
+#!   entered. This requires &GAP; to use the GASMAN memory manager.
+#!
+#!   The size of the heap is the size of the objects which survived the
+#!   last garbage collection, plus those allocated since; objects which
+#!   are no longer used are counted until the next collection. It is not
+#!   the size of the &GAP; process, which does not shrink when memory is
+#!   freed. The size is checked on every statement, so <A>callback</A>
+#!   runs on the statement after the limit is passed. The tripwire fires
+#!   once, and is disabled by passing <B>fail</B> as <A>callback</A>.
+#!
+#!   <A>callback</A>, if given, should accept four arguments: the
+#!   fileid and line number, as for <Ref Func="BreakEveryLine"/>, the
+#!   number of bytes the size has grown by, and a list of the functions
+#!   running, innermost first.
+DeclareGlobalFunction( "BreakOnHeapGrowth" );
+
+#! @Arguments
+#! @Description
+#!   Start keeping a native copy of the stack of running &GAP; functions,
+#!   which is updated as functions are entered and left without calling
+#!   any &GAP; code. Functions which were already running are not on the
+#!   stack. While it is running, the stack is saved each time a breakpoint
+#!   fires, for <Ref Func="LastBreakpointBacktrace"/>.
+DeclareGlobalFunction( "StartShadowStack" );
+
+#! @Arguments
+#! @Description
+#!   Stop keeping the stack started by <Ref Func="StartShadowStack"/>.
+DeclareGlobalFunction( "StopShadowStack" );
+
+#! @Arguments
+#! @Description
+#!   Returns the stack kept by <Ref Func="StartShadowStack"/>, as a list
+#!   of records, innermost function first, or <B>fail</B> if it is not
+#!   running. Each record has components <C>func</C>, <C>file</C> and
+#!   <C>line</C> (the line running in that function, where <C>file</C>
+#!   is <B>fail</B> if it is not known) and <C>time</C>, the nanoseconds
+#!   since the function was entered.
+#!   Unlike <C>Where</C>, this can be used outside of the break loop.
+DeclareGlobalFunction( "ShadowBacktrace" );
+
+#! @Arguments
+#! @Description
+#!   Returns the stack when a breakpoint last fired, in the same form as
+#!   <Ref Func="ShadowBacktrace"/>, or <B>fail</B> if no breakpoint has
+#!   fired since <Ref Func="StartShadowStack"/> was called. The stack is
+#!   only turned into a &GAP; list when this is called.
+DeclareGlobalFunction( "LastBreakpointBacktrace" );
+
+#! @Arguments
+#! @Description
+#!   Returns, for each function called since <Ref Func="StartShadowStack"/>
+#!   was called, the largest number of calls of the function which were
+#!   running at once, as a list of records with components <C>func</C>
+#!   and <C>depth</C>.
+DeclareGlobalFunction( "RecursionDepths" );
+
+#! @Section Profiling
+
+#! @Arguments
+#! @Description
+#!   Start counting how many times each line of code is executed, and how
+#!   much time is spent executing it. This is done without calling any &GAP;
+#!   code, so has much lower overhead than <Ref Func="BreakEveryLine"/>.
+#!   Counts are added to any collected by previous calls, until
+#!   <Ref Func="ClearLineProfile"/> is called.
+DeclareGlobalFunction( "StartLineProfile" );
+
+#! @Arguments
+#! @Description
+#!   Stop the line profiler started by <Ref Func="StartLineProfile"/>.
+DeclareGlobalFunction( "StopLineProfile" );
+
+#! @Arguments
+#! @Description
+#!   Discard all counts collected by the line profiler.
+DeclareGlobalFunction( "ClearLineProfile" );
+
+#! @Arguments
+#! @Description
+#!   Returns the counts collected by the line profiler, as a record
+#!   with components <C>file</C>, <C>line</C>, <C>hits</C> and <C>time</C>.
+#!   Each component is a list, with one entry for each executed line.
+#!   <C>hits</C> is the number of statements executed on the line, and
+#!   <C>time</C> the number of nanoseconds spent between starting to
+#!   execute the line and starting the next statement. The next statement
+#!   may be in a function called from the line, so time spent in called
+#!   functions is charged to their own lines, not the line calling them.
+DeclareGlobalFunction( "LineProfile" );
+
+#! @Arguments
+#! @Description
+#!   Start recording how long each call of each function takes. This is
+#!   done without calling any &GAP; code. Times are added to any collected
+#!   by previous calls, until <Ref Func="ClearFunctionProfile"/> is called.
+DeclareGlobalFunction( "StartFunctionProfile" );
+
+#! @Arguments
+#! @Description
+#!   Stop the function profiler started by <Ref Func="StartFunctionProfile"/>.
+DeclareGlobalFunction( "StopFunctionProfile" );
+
+#! @Arguments
+#! @Description
+#!   Discard all times collected by the function profiler.
+DeclareGlobalFunction( "ClearFunctionProfile" );
+
+#! @Arguments
+#! @Description
+#!   Returns the times collected by the function profiler, as a list
+#!   with one record for each function which was called. Each record has
+#!   components <C>func</C> (the function), <C>calls</C> (the number
+#!   of calls), <C>inclusive</C> and <C>self</C>.
+#!   <P/>
+#!   <C>inclusive</C> describes the time from entering to leaving the
+#!   function, and <C>self</C> the same time excluding functions it called.
+#!   Both are records with components <C>count</C>, <C>total</C>,
+#!   <C>p50</C>, <C>p99</C> and <C>max</C>, with all times in nanoseconds.
+#!   The percentiles are accurate to within 12.5%.
+#!   For recursive functions, <C>inclusive</C> only counts the outermost
+#!   call, so no time is counted twice.
+DeclareGlobalFunction( "FunctionProfile" );
+
+#! @Arguments
+#! @Description
+#!   Start recording how much memory each line and each function allocates,
+#!   by reading the allocation counters of &GAP;'s garbage collector as
+#!   each statement starts. No &GAP; code is called. Memory allocated by
+#!   kernel functions is charged to the line calling them, while memory
+#!   allocated by &GAP; functions is charged to the lines of that function.
+#!   This is only available when &GAP; uses the GASMAN garbage collector.
+DeclareGlobalFunction( "StartAllocationProfile" );
+
+#! @Arguments
+#! @Description
+#!   Stop the profiler started by <Ref Func="StartAllocationProfile"/>.
+DeclareGlobalFunction( "StopAllocationProfile" );
+
+#! @Arguments
+#! @Description
+#!   Discard all counts collected by <Ref Func="StartAllocationProfile"/>.
+DeclareGlobalFunction( "ClearAllocationProfile" );
+
+#! @Arguments [n]
+#! @Description
+#!   Returns the <A>n</A> lines and functions (by default, all of them)
+#!   which allocated the most memory, as a record with components
+#!   <C>lines</C> and <C>functions</C>.
+#!   <C>lines</C> is a record with components <C>file</C>, <C>line</C>,
+#!   <C>bytes</C> and <C>bags</C>, each a list with one entry for each line.
+#!   <C>functions</C> is a list of records with components <C>func</C>,
+#!   <C>bytes</C> and <C>bags</C>, which do not include memory allocated
+#!   by the functions it called. Both are sorted by <C>bytes</C>, largest
+#!   first.
+DeclareGlobalFunction( "AllocationProfile" );
+
+#! @Arguments filename
+#! @Description
+#!   Start counting how often each line is run, and each function is
+#!   called, in the file <A>filename</A>, which is created if it does
+#!   not exist. The counts are updated in place, in memory shared with
+#!   the file, so many &GAP; processes can add to the same file at once,
+#!   and it can be read with <Ref Func="ReadSharedProfile"/> at any time.
+#!   Files are identified by their full path, so the counts from each
+#!   process are combined even though &GAP; numbers files differently in
+#!   each process. Delete the file to start a new profile.
+DeclareGlobalFunction( "StartSharedProfile" );
+
+#! @Arguments
+#! @Description
+#!   Stop adding counts to the file given to
+#!   <Ref Func="StartSharedProfile"/>.
+DeclareGlobalFunction( "StopSharedProfile" );
+
+#! @Arguments filename
+#! @Description
+#!   Read the counts in a file written by <Ref Func="StartSharedProfile"/>,
+#!   as a record with components <C>lines</C>, <C>functions</C> and
+#!   <C>dropped</C>. <C>lines</C> has components <C>file</C>, <C>line</C>
+#!   and <C>hits</C>, as in <Ref Func="LineProfile"/>. <C>functions</C>
+#!   is a list of records with components <C>name</C>, <C>file</C>,
+#!   <C>line</C> (where the function starts) and <C>calls</C>.
+#!   <C>dropped</C> counts the lines and functions which could not be
+#!   recorded because the file was full.
+DeclareGlobalFunction( "ReadSharedProfile" );
+
+#! @Arguments
+#! @Description
+#!   Start recording which lines of code are executed. Each line is
+#!   recorded in a bitmap the first time it runs, after which running it
+#!   costs a single bit test, so this is much faster than
+#!   <Ref Func="BreakEveryLine"/> or <Ref Func="StartLineProfile"/>.
+#!   Lines are added to any recorded by previous calls, until
+#!   <Ref Func="ClearCoverage"/> is called.
+#!   Lines of files read while coverage is running are also recorded,
+#!   so <Ref Func="WriteLcov"/> can report the lines which did not run.
+DeclareGlobalFunction( "StartCoverage" );
+
+#! @Arguments
+#! @Description
+#!   Stop recording coverage started by <Ref Func="StartCoverage"/>.
+DeclareGlobalFunction( "StopCoverage" );
+
+#! @Arguments
+#! @Description
+#!   Discard all coverage recorded by <Ref Func="StartCoverage"/>.
+DeclareGlobalFunction( "ClearCoverage" );
+
+#! @Arguments
+#! @Description
+#!   Returns a list of pairs <C>[filename, lines]</C>, where
+#!   <C>lines</C> is the sorted list of lines of the file which were run.
+DeclareGlobalFunction( "Coverage" );
+
+#! @Arguments filename
+#! @Description
+#!   Write the recorded coverage to <A>filename</A> as an lcov tracefile,
+#!   for use with <F>genhtml</F> or coverage services. Files are given by
+#!   their full path. Returns the number of files written.
+DeclareGlobalFunction( "WriteLcov" );
+
+#! @Arguments [interval]
+#! @Description
+#!   Start a statistical profiler, which records the current stack of
+#!   &GAP; functions every <A>interval</A> microseconds of CPU time
+#!   (default 1000). The stack is recorded at the next line or function
+#!   call after the timer fires, so when no sample is due the overhead is
+#!   very small.
+DeclareGlobalFunction( "StartSampleProfile" );
+
+#! @Arguments
+#! @Description
+#!   Stop the profiler started by <Ref Func="StartSampleProfile"/>.
+DeclareGlobalFunction( "StopSampleProfile" );
+
+#! @Arguments
+#! @Description
+#!   Discard all samples collected by <Ref Func="StartSampleProfile"/>.
+DeclareGlobalFunction( "ClearSampleProfile" );
+
+#! @Arguments
+#! @Description
+#!   Returns the samples collected by <Ref Func="StartSampleProfile"/>
+#!   as a string in the 'folded stacks' format, as read by flamegraph
+#!   tools. Each line is one distinct stack, from the outermost to the
+#!   innermost function separated by <C>;</C>, followed by a space and
+#!   the number of times the stack was seen.
+DeclareGlobalFunction( "SampleProfileFolded" );
+
+#! @Section Tracing
+
+#! @Arguments [size]
+#! @Description
+#!   Start recording a trace of execution in memory. Each time a new line
+#!   of code starts, or a function is entered or left, a small record is
+#!   added to a buffer which holds <A>size</A> events (default 2^20).
+#!   If the buffer fills up, the oldest events are overwritten.
+#!   Events are read with <Ref Func="DrainEventTrace"/>.
+#!   No &GAP; code is run while tracing, so this is much faster than
+#!   <Ref Func="BreakEveryLine"/> or <Ref Func="BreakEveryEnterFunction"/>.
+#!   Giving a different <A>size</A> than the current buffer discards any
+#!   events in it.
+DeclareGlobalFunction( "StartEventTrace" );
+
+#! @Arguments
+#! @Description
+#!   Stop recording events. Events already recorded are kept.
+DeclareGlobalFunction( "StopEventTrace" );
+
+#! @Arguments [max]
+#! @Description
+#!   Removes the oldest <A>max</A> events (default 65536) from the trace
+#!   buffer, and returns them as a list. Each event is a list
+#!   <C>[kind, file, line, func, time]</C>. <C>kind</C> is 1 for
+#!   starting a new line, 2 for entering a function and 3 for leaving
+#!   a function. <C>file</C> is an index into
+#!   <F>GET_FILENAME_CACHE()</F>, and <C>line</C> is the line which starts
+#!   (or for functions, the line the function starts on).
+#!   <C>func</C> is an index into the list returned by
+#!   <Ref Func="EventTraceFunctions"/>, and <C>time</C> is in nanoseconds.
+DeclareGlobalFunction( "DrainEventTrace" );
+
+#! @Arguments
+#! @Description
+#!   Returns the list of functions referred to by events.
+DeclareGlobalFunction( "EventTraceFunctions" );
+
+#! @Arguments
+#! @Description
+#!   Discard all recorded events.
+DeclareGlobalFunction( "ClearEventTrace" );
+
+#! @Arguments filename
+#! @Description
+#!   Start writing a trace of execution to the file <A>filename</A>.
+#!   The same events as <Ref Func="StartEventTrace"/> are recorded, but
+#!   compactly encoded (usually a few bytes per event) and written to disk
+#!   by a background thread, so traces of long runs do not have to fit in
+#!   memory. The file is only complete once <Ref Func="StopTraceFile"/>
+#!   has been called.
+DeclareGlobalFunction( "StartTraceFile" );
+
+#! @Arguments
+#! @Description
+#!   Stop writing the trace file, and close it. Returns the size of the
+#!   file in bytes, or <K>fail</K> if no trace file was being written.
+DeclareGlobalFunction( "StopTraceFile" );
+
+#! @Arguments filename, func[, chunk]
+#! @Description
+#!   Read the trace file <A>filename</A>, calling <A>func</A> on lists of
+#!   at most <A>chunk</A> events (default 65536), so the whole trace is
+#!   never held in memory. Each event is a list
+#!   <C>[kind, filename, line, time]</C>, where <C>kind</C> and
+#!   <C>line</C> are as in <Ref Func="DrainEventTrace"/>, and
+#!   <C>time</C> is in nanoseconds since the trace started.
+DeclareGlobalFunction( "ReadTraceFile" );
+
+#! @Arguments filename
+#! @Description
+#!   Summarise the trace file <A>filename</A>, without creating an object
+#!   for each event. Returns a record with components <C>statements</C>
+#!   and <C>calls</C> (the number of lines started and functions entered),
+#!   <C>duration</C> (in nanoseconds), <C>complete</C> (<K>false</K> if the
+#!   file is truncated) and <C>lines</C>, which has components
+#!   <C>file</C>, <C>line</C> and <C>hits</C> as in
+#!   <Ref Func="LineProfile"/>.
+#!   Traces can also be summarised outside &GAP; by the
+#!   <F>tracesummary</F> tool, built with <C>make tracesummary</C>.
+DeclareGlobalFunction( "TraceFileSummary" );
+
+#! @Arguments filename[, interval[, window]]
+#! @Description
+#!   Start writing a checkpoint trace to <A>filename</A>, to find where two
+#!   runs which should behave the same first go different ways. The file
+#!   and line of every statement are folded into a running hash, which is
+#!   written out every <A>interval</A> statements (default 1000), so even
+#!   long runs give small files. Files are identified by the last part of
+#!   their name, so runs of &GAP; installed in different places can be
+#!   compared. If <A>window</A> is given, it is a record with components
+#!   <C>from</C>, <C>to</C> and <C>trace</C>, and statements <C>from</C>
+#!   to <C>to</C> of the run (counting from 1) are also written to the
+#!   trace file <C>trace</C>, as by <Ref Func="StartTraceFile"/>.
+DeclareGlobalFunction( "StartCheckpointTrace" );
+
+#! @Arguments
+#! @Description
+#!   Stop writing the checkpoint trace, and close it. Returns the number of
+#!   statements run, or <K>fail</K> if no checkpoint trace was being
+#!   written.
+DeclareGlobalFunction( "StopCheckpointTrace" );
+
+#! @Arguments file1, file2
+#! @Description
+#!   Compare two checkpoint files written with the same interval. Returns
+#!   <K>fail</K> if the runs executed the same statements, and otherwise a
+#!   record with components <C>from</C> and <C>to</C>, the first window of
+#!   statements in which they differ. Adding a <C>trace</C> component gives
+#!   a window for <Ref Func="StartCheckpointTrace"/>, to trace just the
+#!   statements where the runs diverge.
+#!   Checkpoint files can also be compared outside &GAP; by the
+#!   <F>checkpointdiff</F> tool, built with <C>make checkpointdiff</C>.
+DeclareGlobalFunction( "FirstCheckpointDifference" );
+
+#! @Arguments
+#! @Description
+#!   Start recording when each function is entered and left, to be viewed
+#!   as a timeline in <C>chrome://tracing</C> or the Perfetto UI. Events
+#!   are kept in memory until written with <Ref Func="WriteChromeTrace"/>.
+DeclareGlobalFunction( "StartChromeTrace" );
+
+#! @Arguments
+#! @Description
+#!   Stop recording function entries and exits. Events already recorded
+#!   are kept, and functions which have not been left are ended now.
+DeclareGlobalFunction( "StopChromeTrace" );
+
+#! @Arguments filename
+#! @Description
+#!   Write the events recorded so far to <A>filename</A>, in Trace Event
+#!   Format JSON. Each function's name and location are written once,
+#!   and referred to from its events. Functions which have not been left
+#!   yet are ended at the last event. Returns the number of events which
+#!   were dropped because too many events had been recorded.
+DeclareGlobalFunction( "WriteChromeTrace" );
+
+#! @Arguments
+#! @Description
+#!   Discard all recorded function entries and exits.
+DeclareGlobalFunction( "ClearChromeTrace" );
+
+
 #! @Section Information in the Break loop
 
+#! @Arguments [options]
 #! @Description
 #!      Show arguments and local variables of the current function,
-#!      and their current values
+#!      and their current values. In the break loop, this is the function
+#!      where the break loop started, otherwise it is the function which
+#!      called <Ref Func="ShowLocals"/>.
+#!
+#!      Each value is followed by its type and the number of bytes of memory
+#!      used by it and the objects it contains. Large values are shortened,
+#!      so very large lists or groups do not take long to show.
+#!      <A>options</A> is a record, whose component <C>bytes</C> (default
+#!      1000) limits the length of each value shown, and <C>elements</C>
+#!      (default 10) limits how many entries of each list and record are
+#!      shown. Use <Ref Func="ShowLocal"/> to look at part of a value.
 DeclareGlobalFunction( "ShowLocals");
+
+#! @Arguments name[, steps...][, options]
+#! @Description
+#!      Show the value of the argument or local variable <A>name</A>, as
+#!      <Ref Func="ShowLocals"/> does. Each of <A>steps</A> moves into part
+#!      of the value: a string selects a component of a record, a positive
+#!      integer an entry of a list, and a list of positive integers a
+#!      sublist. For example <C>ShowLocal("l", [100..120])</C> shows
+#!      entries 100 to 120 of <C>l</C>, and <C>ShowLocal("r", "gens", 1)</C>
+#!      the first entry of <C>r.gens</C>.
+DeclareGlobalFunction( "ShowLocal");
@@ -0,0 +1,269 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * A native allocation profiler. GASMAN counts the bags, and bytes, it has
+ * allocated since GAP started. We read these counters at each statement
+ * and function call, and charge the change to the line, and the function,
+ * which was running.
+ */
+
+#include "debugger.h"
+#include "function_table.hpp"
+
+#include <algorithm>
+#include <vector>
+
+bool alloc_profile_active;
+
+struct AllocCounts
+{
+    uint64_t bytes;
+    uint64_t bags;
+};
+
+static inline AllocCounts readAllocCounters()
+{
+#ifdef USE_GASMAN
+    AllocCounts c = { (uint64_t)SizeAllBags, (uint64_t)NrAllBags };
+#else
+    AllocCounts c = { 0, 0 };
+#endif
+    return c;
+}
+
+// Counts for each line, indexed first by file id, then by line
+static std::vector<std::vector<AllocCounts> > line_allocs;
+
+// The line currently running, which is charged for everything allocated
+// since 'prev_line_counts'. Memory allocated by kernel functions is
+// charged to the line which called them.
+static Int prev_file;
+static Int prev_line;
+static AllocCounts prev_line_counts;
+
+static FunctionTable alloc_functions;
+
+// Allocations made by each function itself, not including functions it
+// called, indexed by the position of the function in alloc_functions
+static std::vector<AllocCounts> function_allocs;
+
+struct AllocFrame
+{
+    Int function;
+    // The line which called the function, which is charged again once
+    // the function returns
+    Int file;
+    Int line;
+};
+
+// The functions currently running. The last is charged for allocations
+// made since 'prev_function_counts'
+static std::vector<AllocFrame> alloc_stack;
+static AllocCounts prev_function_counts;
+
+static inline void charge(AllocCounts& to, const AllocCounts& from,
+                          const AllocCounts& now)
+{
+    to.bytes += now.bytes - from.bytes;
+    to.bags += now.bags - from.bags;
+}
+
+static void chargeAll(const AllocCounts& now)
+{
+    if(prev_file != 0)
+        charge(line_allocs[prev_file][prev_line], prev_line_counts, now);
+    prev_line_counts = now;
+    if(!alloc_stack.empty())
+        charge(function_allocs[alloc_stack.back().function], prev_function_counts, now);
+    prev_function_counts = now;
+}
+
+void allocProfileVisitStat(Int file, Int line)
+{
+    chargeAll(readAllocCounters());
+
+    if((UInt)file >= line_allocs.size())
+        line_allocs.resize(file + 1);
+    std::vector<AllocCounts>& counts = line_allocs[file];
+    if((UInt)line >= counts.size())
+    {
+        AllocCounts zero = { 0, 0 };
+        counts.resize(line + 1, zero);
+    }
+
+    prev_file = file;
+    prev_line = line;
+}
+
+void allocProfileEnter(Obj func)
+{
+    // Looking up a new function can allocate, so do this first
+    Int pos = alloc_functions.lookup(func);
+    if((UInt)pos >= function_allocs.size())
+    {
+        AllocCounts zero = { 0, 0 };
+        function_allocs.resize(pos + 1, zero);
+    }
+    chargeAll(readAllocCounters());
+    AllocFrame frame = { pos, prev_file, prev_line };
+    alloc_stack.push_back(frame);
+    prev_file = 0;
+}
+
+void allocProfileLeave(Obj func)
+{
+    chargeAll(readAllocCounters());
+    Int pos = alloc_functions.lookup(func);
+    // As in the function profiler, drop frames until the stack matches
+    UInt depth = alloc_stack.size();
+    while(depth > 0 && alloc_stack[depth - 1].function != pos)
+        depth--;
+    if(depth == 0)
+    {
+        prev_file = 0;
+        return;
+    }
+    prev_file = alloc_stack[depth - 1].file;
+    prev_line = alloc_stack[depth - 1].line;
+    alloc_stack.resize(depth - 1);
+}
+
+void allocProfileReset()
+{
+    alloc_stack.clear();
+    prev_file = 0;
+}
+
+static void startAllocCounts()
+{
+    prev_file = 0;
+    prev_function_counts = readAllocCounters();
+}
+
+static Obj FuncSTART_ALLOCATION_PROFILE(Obj self)
+{
+#ifndef USE_GASMAN
+    ErrorMayQuit("StartAllocationProfile: requires GAP to use GASMAN",0,0);
+#endif
+    alloc_profile_active = true;
+    startAllocCounts();
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncSTOP_ALLOCATION_PROFILE(Obj self)
+{
+    alloc_profile_active = false;
+    allocProfileReset();
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncCLEAR_ALLOCATION_PROFILE(Obj self)
+{
+    line_allocs.clear();
+    function_allocs.clear();
+    alloc_functions.clear();
+    allocProfileReset();
+    startAllocCounts();
+    return 0;
+}
+
+static bool moreBytes(const std::pair<AllocCounts, std::pair<Int, Int> >& a,
+                      const std::pair<AllocCounts, std::pair<Int, Int> >& b)
+{
+    if(a.first.bytes != b.first.bytes)
+        return a.first.bytes > b.first.bytes;
+    return a.second < b.second;
+}
+
+// Returns the top 'objcount' lines and functions (or all if 'objcount'
+// is 0), ordered by the number of bytes allocated
+static Obj FuncGET_ALLOCATION_PROFILE(Obj self, Obj objcount)
+{
+    if(!IS_INTOBJ(objcount) || INT_INTOBJ(objcount) < 0)
+    {
+        ErrorMayQuit("Usage: AllocationProfile([n]), where n is a positive integer",0,0);
+    }
+    UInt limit = INT_INTOBJ(objcount);
+
+    // (counts, (file, line)), or (counts, (function, 0))
+    std::vector<std::pair<AllocCounts, std::pair<Int, Int> > > entries;
+    for(UInt file = 1; file < line_allocs.size(); ++file)
+    {
+        for(UInt line = 1; line < line_allocs[file].size(); ++line)
+        {
+            const AllocCounts& c = line_allocs[file][line];
+            if(c.bags != 0)
+                entries.push_back(std::make_pair(c, std::make_pair(file, line)));
+        }
+    }
+    std::sort(entries.begin(), entries.end(), moreBytes);
+    if(limit != 0 && entries.size() > limit)
+        entries.resize(limit);
+
+    Obj lines = NEW_PREC(4);
+    Obj files = NEW_PLIST(T_PLIST, 0);
+    Obj linenums = NEW_PLIST(T_PLIST, 0);
+    Obj bytes = NEW_PLIST(T_PLIST, 0);
+    Obj bags = NEW_PLIST(T_PLIST, 0);
+    for(UInt i = 0; i < entries.size(); ++i)
+    {
+        PushPlist(files, GetCachedFilename(entries[i].second.first));
+        PushPlist(linenums, INTOBJ_INT(entries[i].second.second));
+        PushPlist(bytes, ObjInt_UInt8(entries[i].first.bytes));
+        PushPlist(bags, ObjInt_UInt8(entries[i].first.bags));
+    }
+    AssPRec(lines, RNamName("file"), files);
+    AssPRec(lines, RNamName("line"), linenums);
+    AssPRec(lines, RNamName("bytes"), bytes);
+    AssPRec(lines, RNamName("bags"), bags);
+
+    entries.clear();
+    for(UInt i = 0; i < function_allocs.size(); ++i)
+    {
+        if(function_allocs[i].bags != 0)
+            entries.push_back(std::make_pair(function_allocs[i], std::make_pair((Int)i, (Int)0)));
+    }
+    std::sort(entries.begin(), entries.end(), moreBytes);
+    if(limit != 0 && entries.size() > limit)
+        entries.resize(limit);
+
+    Obj functions = NEW_PLIST(T_PLIST, entries.size());
+    for(UInt i = 0; i < entries.size(); ++i)
+    {
+        Obj rec = NEW_PREC(3);
+        AssPRec(rec, RNamName("func"), alloc_functions.function(entries[i].second.first));
+        AssPRec(rec, RNamName("bytes"), ObjInt_UInt8(entries[i].first.bytes));
+        AssPRec(rec, RNamName("bags"), ObjInt_UInt8(entries[i].first.bags));
+        PushPlist(functions, rec);
+    }
+
+    Obj result = NEW_PREC(2);
+    AssPRec(result, RNamName("lines"), lines);
+    AssPRec(result, RNamName("functions"), functions);
+    return result;
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(START_ALLOCATION_PROFILE, 0, ""),
+    GVAR_FUNC(STOP_ALLOCATION_PROFILE, 0, ""),
+    GVAR_FUNC(CLEAR_ALLOCATION_PROFILE, 0, ""),
+    GVAR_FUNC(GET_ALLOCATION_PROFILE, 1, "count"),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelAllocationProfile()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    InitGlobalBag(&alloc_functions.functions, "src/allocprofile.cc:alloc_functions");
+    return 0;
+}
+
+Int InitLibraryAllocationProfile()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    alloc_functions.init();
+    return 0;
+}
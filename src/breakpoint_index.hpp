@@ -0,0 +1,119 @@
+#ifndef BREAKPOINT_INDEX_HPP_QKWZ
+#define BREAKPOINT_INDEX_HPP_QKWZ
+
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "gap_all.h"   // GAP headers
+
+// An index of breakpoint locations, so checking if a (file, line) pair has
+// a breakpoint does not require scanning the list of all breakpoints.
+//
+// For each file id we store a bitmap with one bit per line, which answers
+// the common question ("is there a breakpoint here?") with two loads.
+// Only when a bit is set do we look in a hash table, which maps the
+// location to the positions in the list of breakpoints.
+class BreakpointIndex
+{
+    std::vector<std::vector<uint64_t> > line_bits;
+    std::unordered_map<uint64_t, std::vector<Int> > positions;
+    // Incremented on every change, so users can cache query results
+    UInt generation_count;
+
+    static uint64_t key(Int file, Int line)
+    { return ((uint64_t)file << 32) ^ (uint64_t)line; }
+
+public:
+    BreakpointIndex() : generation_count(0)
+    { }
+
+    UInt generation() const
+    { return generation_count; }
+
+    bool contains(Int file, Int line) const
+    {
+        if(file <= 0 || line <= 0 || (UInt)file >= line_bits.size())
+            return false;
+        const std::vector<uint64_t>& bits = line_bits[file];
+        UInt word = (UInt)line / 64;
+        if(word >= bits.size())
+            return false;
+        return (bits[word] >> (line % 64)) & 1;
+    }
+
+    // Returns true if any breakpoint is set in this file
+    bool containsFile(Int file) const
+    { return file > 0 && (UInt)file < line_bits.size() && !line_bits[file].empty(); }
+
+    // Returns true if any breakpoint is set in this file, on a line
+    // between first and last (inclusive). If the range is not valid, checks
+    // the whole file.
+    bool containsRange(Int file, Int first, Int last) const
+    {
+        if(!containsFile(file))
+            return false;
+        const std::vector<uint64_t>& bits = line_bits[file];
+        if(first < 0)
+            first = 0;
+        if(last < first || (UInt)last >= bits.size() * 64)
+            last = bits.size() * 64 - 1;
+        for(Int line = first; line <= last; ++line)
+        {
+            uint64_t word = bits[line / 64];
+            if(word == 0)
+                line |= 63;
+            else if((word >> (line % 64)) & 1)
+                return true;
+        }
+        return false;
+    }
+
+    // Returns the (0-indexed) positions of breakpoints at this location,
+    // or 0 if there are none.
+    const std::vector<Int>* find(Int file, Int line) const
+    {
+        if(!contains(file, line))
+            return 0;
+        std::unordered_map<uint64_t, std::vector<Int> >::const_iterator it =
+            positions.find(key(file, line));
+        if(it == positions.end())
+            return 0;
+        return &(it->second);
+    }
+
+    void add(Int file, Int line, Int pos)
+    {
+        if(file <= 0 || line <= 0)
+            return;
+        if((UInt)file >= line_bits.size())
+            line_bits.resize(file + 1);
+        std::vector<uint64_t>& bits = line_bits[file];
+        UInt word = (UInt)line / 64;
+        if(word >= bits.size())
+            bits.resize(word + 1, 0);
+        bits[word] |= ((uint64_t)1 << (line % 64));
+        positions[key(file, line)].push_back(pos);
+        generation_count++;
+    }
+
+    void clear()
+    {
+        line_bits.clear();
+        positions.clear();
+        generation_count++;
+    }
+
+    // Positions are indices into the list of breakpoints, so whenever a
+    // breakpoint is removed we rebuild from scratch. Removing breakpoints is
+    // rare compared to checking them.
+    void rebuild(const std::vector<std::pair<Int, Int> >& break_points)
+    {
+        clear();
+        for(UInt i = 0; i < break_points.size(); ++i)
+            add(break_points[i].first, break_points[i].second, i);
+    }
+};
+
+#endif
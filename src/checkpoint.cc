@@ -0,0 +1,238 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * Checkpoint traces, for finding where two runs of GAP first execute
+ * different code. The location of every statement is folded into a
+ * running hash, and the hash is written out every few statements, so even
+ * very long runs give small files. Comparing two files finds the first
+ * window of statements which differs, and a second run can then write a
+ * full trace file of just that window.
+ */
+
+#include "debugger.h"
+#include "checkpoint_format.hpp"
+
+#include <stdio.h>
+
+#include <vector>
+
+bool checkpoint_active;
+
+// Checkpoints are written in blocks of this many
+#define CHECKPOINT_BUFFER 4096
+
+static FILE* checkpoint_out;
+static std::vector<Checkpoint> checkpoint_buffer;
+static uint64_t checkpoint_interval;
+static uint64_t checkpoint_countdown;
+static uint64_t checkpoint_statements;
+static uint64_t checkpoint_hash;
+static bool checkpoint_write_failed;
+
+// For each file id, checkpointFileHash of its name, or 0 if not yet known
+static std::vector<uint64_t> checkpoint_file_hashes;
+
+// Statements from 'detail_from' to 'detail_to' (counting from 1) are
+// written to the trace file 'detail_filename' with StartTraceFile
+static uint64_t detail_from;
+static uint64_t detail_to;
+static Obj detail_filename;
+static bool detail_running;
+
+static void flushCheckpoints()
+{
+    if(!checkpoint_buffer.empty() &&
+       fwrite(&checkpoint_buffer[0], sizeof(Checkpoint), checkpoint_buffer.size(),
+              checkpoint_out) != checkpoint_buffer.size())
+        checkpoint_write_failed = true;
+    checkpoint_buffer.clear();
+}
+
+static void addCheckpoint()
+{
+    Checkpoint point = { checkpoint_statements, checkpoint_hash };
+    checkpoint_buffer.push_back(point);
+    if(checkpoint_buffer.size() >= CHECKPOINT_BUFFER)
+        flushCheckpoints();
+}
+
+static void callTraceFunction(const char* name, Obj arg)
+{
+    Obj func = VAL_GVAR(GVarName(name));
+    disable_debugger = 1;
+    if(arg)
+        CALL_1ARGS(func, arg);
+    else
+        CALL_0ARGS(func);
+    disable_debugger = 0;
+}
+
+static void updateDetailTrace()
+{
+    if(checkpoint_statements == detail_from && !detail_running)
+    {
+        detail_running = true;
+        callTraceFunction("START_TRACE_FILE", detail_filename);
+    }
+    else if(checkpoint_statements == detail_to + 1 && detail_running)
+    {
+        detail_running = false;
+        callTraceFunction("STOP_TRACE_FILE", 0);
+    }
+}
+
+void checkpointVisitStat(Int file, Int line)
+{
+    if((UInt)file >= checkpoint_file_hashes.size())
+        checkpoint_file_hashes.resize(file + 1, 0);
+    uint64_t filehash = checkpoint_file_hashes[file];
+    if(filehash == 0)
+    {
+        Obj name = GetCachedFilename(file);
+        filehash = checkpointFileHash(name && IS_STRING_REP(name)
+                                          ? CONST_CSTR_STRING(name) : "unknown");
+        checkpoint_file_hashes[file] = filehash;
+    }
+    checkpoint_hash = checkpointFold(checkpoint_hash, filehash, line);
+    checkpoint_statements++;
+    if(detail_filename)
+        updateDetailTrace();
+    if(--checkpoint_countdown == 0)
+    {
+        addCheckpoint();
+        checkpoint_countdown = checkpoint_interval;
+    }
+}
+
+static Obj FuncSTART_CHECKPOINT_TRACE(Obj self, Obj filename, Obj interval,
+                                      Obj window)
+{
+    if(!IS_STRING_REP(filename) || !IS_POS_INTOBJ(interval))
+    {
+        ErrorMayQuit("Usage: StartCheckpointTrace(filename[, interval[, window]])",0,0);
+    }
+    if(window != Fail &&
+       (!IS_PLIST(window) || LEN_PLIST(window) != 3 ||
+        !IS_POS_INTOBJ(ELM_PLIST(window, 1)) || !IS_POS_INTOBJ(ELM_PLIST(window, 2)) ||
+        !IS_STRING_REP(ELM_PLIST(window, 3))))
+    {
+        ErrorMayQuit("The window must be [from, to, tracefile]",0,0);
+    }
+    if(checkpoint_active)
+    {
+        ErrorMayQuit("A checkpoint trace is already being written",0,0);
+    }
+    checkpoint_out = fopen(CONST_CSTR_STRING(filename), "wb");
+    if(!checkpoint_out)
+    {
+        ErrorMayQuit("Unable to open checkpoint file '%s'",
+                     (Int)CONST_CSTR_STRING(filename),0);
+    }
+    CheckpointHeader header;
+    memcpy(header.magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LEN);
+    header.interval = INT_INTOBJ(interval);
+    checkpoint_write_failed = fwrite(&header, sizeof(header), 1, checkpoint_out) != 1;
+
+    checkpoint_buffer.clear();
+    checkpoint_buffer.reserve(CHECKPOINT_BUFFER);
+    checkpoint_interval = header.interval;
+    checkpoint_countdown = checkpoint_interval;
+    checkpoint_statements = 0;
+    checkpoint_hash = CHECKPOINT_HASH_START;
+    checkpoint_file_hashes.clear();
+    detail_running = false;
+    if(window != Fail)
+    {
+        detail_from = INT_INTOBJ(ELM_PLIST(window, 1));
+        detail_to = INT_INTOBJ(ELM_PLIST(window, 2));
+        detail_filename = ELM_PLIST(window, 3);
+    }
+    else
+        detail_filename = 0;
+
+    checkpoint_active = true;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+// Stop, writing a final checkpoint for any statements since the last one.
+// Returns the number of statements run.
+static Obj FuncSTOP_CHECKPOINT_TRACE(Obj self)
+{
+    if(!checkpoint_active)
+        return Fail;
+    checkpoint_active = false;
+    ConsiderEnableDisableDebugging();
+    if(detail_running)
+    {
+        detail_running = false;
+        callTraceFunction("STOP_TRACE_FILE", 0);
+    }
+    detail_filename = 0;
+    if(checkpoint_countdown != checkpoint_interval)
+        addCheckpoint();
+    flushCheckpoints();
+    if(fclose(checkpoint_out) != 0)
+        checkpoint_write_failed = true;
+    checkpoint_out = 0;
+    if(checkpoint_write_failed)
+    {
+        ErrorMayQuit("Failed to write checkpoint file",0,0);
+    }
+    return ObjInt_UInt8(checkpoint_statements);
+}
+
+// Returns fail if two checkpoint files are identical, or otherwise the
+// statements of the first window which differs, as rec(from, to)
+static Obj FuncFIRST_CHECKPOINT_DIFFERENCE(Obj self, Obj file1, Obj file2)
+{
+    if(!IS_STRING_REP(file1) || !IS_STRING_REP(file2))
+    {
+        ErrorMayQuit("Usage: FirstCheckpointDifference(file1, file2)",0,0);
+    }
+    CheckpointHeader header1, header2;
+    std::vector<Checkpoint> points1, points2;
+    if(!readCheckpointFile(CONST_CSTR_STRING(file1), header1, points1))
+    {
+        ErrorMayQuit("'%s' is not a checkpoint file", (Int)CONST_CSTR_STRING(file1),0);
+    }
+    if(!readCheckpointFile(CONST_CSTR_STRING(file2), header2, points2))
+    {
+        ErrorMayQuit("'%s' is not a checkpoint file", (Int)CONST_CSTR_STRING(file2),0);
+    }
+    if(header1.interval != header2.interval)
+    {
+        ErrorMayQuit("Checkpoint files have different intervals",0,0);
+    }
+    size_t i = firstCheckpointDifference(points1.empty() ? 0 : &points1[0], points1.size(),
+                                         points2.empty() ? 0 : &points2[0], points2.size());
+    if(i == points1.size() && points1.size() == points2.size())
+        return Fail;
+    uint64_t from = i == 0 ? 1 : points1[i - 1].statements + 1;
+    uint64_t to = from + header1.interval - 1;
+    Obj result = NEW_PREC(2);
+    AssPRec(result, RNamName("from"), ObjInt_UInt8(from));
+    AssPRec(result, RNamName("to"), ObjInt_UInt8(to));
+    return result;
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(START_CHECKPOINT_TRACE, 3, "filename, interval, window"),
+    GVAR_FUNC(STOP_CHECKPOINT_TRACE, 0, ""),
+    GVAR_FUNC(FIRST_CHECKPOINT_DIFFERENCE, 2, "file1, file2"),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelCheckpoint()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    InitGlobalBag(&detail_filename, "src/checkpoint.cc:detail_filename");
+    return 0;
+}
+
+Int InitLibraryCheckpoint()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    return 0;
+}
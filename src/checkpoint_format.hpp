@@ -0,0 +1,110 @@
+#ifndef CHECKPOINT_FORMAT_HPP_KDWQZN
+#define CHECKPOINT_FORMAT_HPP_KDWQZN
+
+// The format of checkpoint files written by StartCheckpointTrace.
+// This file does not depend on GAP, so it can be used by standalone tools.
+//
+// Every statement run folds its location into a running hash. A checkpoint
+// file is the 8 bytes of CHECKPOINT_MAGIC, the checkpoint interval, and
+// then a Checkpoint after every 'interval' statements, plus one at the end
+// of the run if there were statements since the last one. All numbers are
+// 64 bit, in the byte order of the machine which wrote the file.
+//
+// The hash of a checkpoint depends on every statement before it, so once
+// two runs differ, every later checkpoint differs, and the first
+// difference can be found by binary search.
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CHECKPOINT_MAGIC "GAPCHK01"
+#define CHECKPOINT_MAGIC_LEN 8
+
+struct CheckpointHeader
+{
+    char magic[CHECKPOINT_MAGIC_LEN];
+    uint64_t interval;
+};
+
+struct Checkpoint
+{
+    // Statements run so far
+    uint64_t statements;
+    uint64_t hash;
+};
+
+inline bool operator==(const Checkpoint& a, const Checkpoint& b)
+{ return a.statements == b.statements && a.hash == b.hash; }
+
+inline bool operator!=(const Checkpoint& a, const Checkpoint& b)
+{ return !(a == b); }
+
+#define CHECKPOINT_HASH_START 14695981039346656037ULL
+
+// Fold the location of one statement into the running hash
+inline uint64_t checkpointFold(uint64_t hash, uint64_t file, uint64_t line)
+{
+    hash ^= file + (line << 1);
+    hash *= 1099511628211ULL;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+// A hash of the last part of a path (after the final '/'), so runs of
+// GAP installed in different places can be compared
+inline uint64_t checkpointFileHash(const char* path)
+{
+    const char* base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    uint64_t h = CHECKPOINT_HASH_START;
+    for(; *base; ++base)
+    {
+        h ^= (unsigned char)*base;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// The index of the first checkpoint which differs between 'a' and 'b',
+// or 'na' if they are identical. If one run is a prefix of the other, the
+// first checkpoint only present in the longer run is the difference.
+inline size_t firstCheckpointDifference(const Checkpoint* a, size_t na,
+                                        const Checkpoint* b, size_t nb)
+{
+    size_t common = na < nb ? na : nb;
+    size_t lo = 0, hi = common;
+    // Every checkpoint before 'lo' matches, everything from 'hi' on may not
+    while(lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if(a[mid] == b[mid])
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if(lo == common && na == nb)
+        return na;
+    return lo;
+}
+
+// Reads a checkpoint file into 'header' and 'points'. Returns false if
+// it is not a checkpoint file.
+template<typename Vector>
+inline bool readCheckpointFile(const char* filename, CheckpointHeader& header,
+                               Vector& points)
+{
+    FILE* in = fopen(filename, "rb");
+    if(!in)
+        return false;
+    bool ok = fread(&header, sizeof(header), 1, in) == 1 &&
+              memcmp(header.magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LEN) == 0;
+    Checkpoint point;
+    while(ok && fread(&point, sizeof(point), 1, in) == 1)
+        points.push_back(point);
+    fclose(in);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,245 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * Records function entries and exits with native timestamps, and writes
+ * them in the Trace Event Format read by chrome://tracing and Perfetto,
+ * so a run can be viewed as a timeline.
+ */
+
+#include "debugger.h"
+#include "function_table.hpp"
+#include "timer.hpp"
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+bool chrome_trace_active;
+
+// We stop recording (and count dropped events) after this many events
+#define MAX_CHROME_EVENTS (1 << 24)
+
+struct ChromeEvent
+{
+    // Index in chrome_functions, or CHROME_LEAVE for leaving a function
+    UInt4 function;
+    uint64_t ticks;
+};
+
+#define CHROME_LEAVE ((UInt4)1 << 31)
+
+static FunctionTable chrome_functions;
+static std::vector<ChromeEvent> chrome_events;
+static UInt chrome_dropped;
+
+// The number of functions entered while tracing which have not yet been
+// left, so we do not record leaving functions entered before we started.
+static Int chrome_depth;
+
+static uint64_t chrome_start_ticks;
+static TickCalibration chrome_calibration;
+
+static void pushChromeEvent(UInt4 function)
+{
+    if(chrome_events.size() >= MAX_CHROME_EVENTS)
+    {
+        chrome_dropped++;
+        return;
+    }
+    ChromeEvent e = { function, readTicks() };
+    chrome_events.push_back(e);
+}
+
+void chromeTraceEnter(Obj func)
+{
+    chrome_depth++;
+    pushChromeEvent(chrome_functions.lookup(func));
+}
+
+void chromeTraceLeave(Obj func)
+{
+    if(chrome_depth == 0)
+        return;
+    chrome_depth--;
+    pushChromeEvent(CHROME_LEAVE);
+}
+
+// End every function entered while tracing which has not been left
+static void closeChromeFrames()
+{
+    for(; chrome_depth > 0; chrome_depth--)
+        pushChromeEvent(CHROME_LEAVE);
+}
+
+// We are not told which functions GAP jumped out of, but they include all
+// those it has not yet left, so end them all, and from now on only record
+// leaving functions entered after the jump.
+void chromeTraceReset()
+{
+    if(chrome_trace_active)
+        closeChromeFrames();
+    chrome_depth = 0;
+}
+
+static Obj FuncSTART_CHROME_TRACE(Obj self)
+{
+    if(chrome_events.empty())
+    {
+        chrome_calibration.reset();
+        chrome_start_ticks = readTicks();
+    }
+    chrome_depth = 0;
+    chrome_trace_active = true;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncSTOP_CHROME_TRACE(Obj self)
+{
+    // We will not see these functions being left
+    closeChromeFrames();
+    chrome_trace_active = false;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncCLEAR_CHROME_TRACE(Obj self)
+{
+    std::vector<ChromeEvent>().swap(chrome_events);
+    chrome_functions.clear();
+    chrome_dropped = 0;
+    chrome_depth = 0;
+    chrome_calibration.reset();
+    chrome_start_ticks = readTicks();
+    return 0;
+}
+
+static void appendJsonString(std::string& out, const char* s)
+{
+    out += '"';
+    for(; *s; ++s)
+    {
+        unsigned char c = *s;
+        if(c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if(c < 0x20)
+        {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        }
+        else
+            out += c;
+    }
+    out += '"';
+}
+
+// Write the events recorded so far to 'filename'. Each function's name
+// and location are written once, in the 'stackFrames' table, and begin
+// events only refer to their function's stack frame by index. Functions
+// which have not been left yet are ended at the last event.
+static Obj FuncWRITE_CHROME_TRACE(Obj self, Obj filename)
+{
+    if(!IS_STRING_REP(filename))
+    {
+        ErrorMayQuit("Usage: WriteChromeTrace(filename)",0,0);
+    }
+    FILE* out = fopen(CONST_CSTR_STRING(filename), "w");
+    if(!out)
+    {
+        ErrorMayQuit("Unable to open '%s'", (Int)CONST_CSTR_STRING(filename),0);
+    }
+
+    std::string frames;
+    for(Int i = 0; i < chrome_functions.size(); ++i)
+    {
+        Obj func = chrome_functions.function(i);
+        Obj name = NAME_FUNC(func);
+        Obj body = BODY_FUNC(func);
+        Obj file = GET_FILENAME_BODY(body);
+        std::string location;
+        if(file && IS_STRING_REP(file))
+        {
+            location = CONST_CSTR_STRING(file);
+            location += ":";
+            location += std::to_string((long long)GET_STARTLINE_BODY(body));
+        }
+        else
+            location = "<kernel>";
+        if(i > 0)
+            frames += ",\n";
+        frames += "\"" + std::to_string((long long)i) + "\":{\"name\":";
+        appendJsonString(frames, (name && IS_STRING_REP(name))
+                                     ? CONST_CSTR_STRING(name) : "<anonymous>");
+        frames += ",\"category\":";
+        appendJsonString(frames, location.c_str());
+        frames += "}";
+    }
+
+    fputs("{\"displayTimeUnit\":\"ns\",\n\"stackFrames\":{\n", out);
+    fputs(frames.c_str(), out);
+    fputs("},\n\"traceEvents\":[\n"
+          "{\"ph\":\"M\",\"pid\":1,\"tid\":1,\"name\":\"process_name\","
+          "\"args\":{\"name\":\"GAP\"}}", out);
+
+    // Timestamps are in microseconds, printed to the nanosecond
+    double scale = chrome_calibration.nanosPerTick();
+    unsigned long long us = 0, frac = 0;
+    UInt open = 0;
+    for(UInt i = 0; i < chrome_events.size(); ++i)
+    {
+        const ChromeEvent& e = chrome_events[i];
+        uint64_t ns = (uint64_t)((e.ticks - chrome_start_ticks) * scale);
+        us = ns / 1000;
+        frac = ns % 1000;
+        if(e.function == CHROME_LEAVE)
+        {
+            fprintf(out, ",\n{\"ph\":\"E\",\"pid\":1,\"tid\":1,\"ts\":%llu.%03llu}",
+                    us, frac);
+            if(open > 0)
+                open--;
+        }
+        else
+        {
+            fprintf(out, ",\n{\"ph\":\"B\",\"pid\":1,\"tid\":1,\"ts\":%llu.%03llu,"
+                    "\"sf\":%u}", us, frac, (unsigned)e.function);
+            open++;
+        }
+    }
+    for(; open > 0; open--)
+        fprintf(out, ",\n{\"ph\":\"E\",\"pid\":1,\"tid\":1,\"ts\":%llu.%03llu}",
+                us, frac);
+    fputs("\n]}\n", out);
+    if(fclose(out) != 0)
+    {
+        ErrorMayQuit("Error writing '%s'", (Int)CONST_CSTR_STRING(filename),0);
+    }
+    return ObjInt_UInt(chrome_dropped);
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(START_CHROME_TRACE, 0, ""),
+    GVAR_FUNC(STOP_CHROME_TRACE, 0, ""),
+    GVAR_FUNC(CLEAR_CHROME_TRACE, 0, ""),
+    GVAR_FUNC(WRITE_CHROME_TRACE, 1, "filename"),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelChromeTrace()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    InitGlobalBag(&chrome_functions.functions, "src/chrometrace.cc:chrome_functions");
+    return 0;
+}
+
+Int InitLibraryChromeTrace()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    chrome_functions.init();
+    return 0;
+}
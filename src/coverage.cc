@@ -0,0 +1,223 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * Line coverage. Each file has a bitmap with one bit per line, which is
+ * set the first time the line runs, so once a line is covered checking
+ * it again is a single bit test. A second bitmap records the lines GAP
+ * read while coverage was running, so unexecuted lines can be reported.
+ */
+
+#include "debugger.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+bool coverage_active;
+
+typedef std::vector<uint64_t> LineBitmap;
+
+// Indexed by file id
+static std::vector<LineBitmap> covered_lines;
+static std::vector<LineBitmap> known_lines;
+
+static inline bool testBit(const std::vector<LineBitmap>& bitmaps,
+                           Int file, Int line)
+{
+    return (UInt)file < bitmaps.size() &&
+           (UInt)(line / 64) < bitmaps[file].size() &&
+           (bitmaps[file][line / 64] >> (line % 64)) & 1;
+}
+
+static void setBit(std::vector<LineBitmap>& bitmaps, Int file, Int line)
+{
+    if((UInt)file >= bitmaps.size())
+        bitmaps.resize(file + 1);
+    LineBitmap& bits = bitmaps[file];
+    if((UInt)(line / 64) >= bits.size())
+        bits.resize(line / 64 + 1, 0);
+    bits[line / 64] |= (uint64_t)1 << (line % 64);
+}
+
+void coverageVisitStat(Int file, Int line)
+{
+    if(file <= 0 || line <= 0 || testBit(covered_lines, file, line))
+        return;
+    setBit(covered_lines, file, line);
+}
+
+void coverageRegisterStat(Int file, Int line)
+{
+    if(file <= 0 || line <= 0)
+        return;
+    setBit(known_lines, file, line);
+}
+
+static Obj FuncSTART_COVERAGE(Obj self)
+{
+    coverage_active = true;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncSTOP_COVERAGE(Obj self)
+{
+    coverage_active = false;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncCLEAR_COVERAGE(Obj self)
+{
+    covered_lines.clear();
+    known_lines.clear();
+    return 0;
+}
+
+// Calls 'func(file, line, covered)' for each line covered or read, in
+// order of file id and line
+template<typename Func>
+static void forEachLine(Func func)
+{
+    UInt files = std::max(covered_lines.size(), known_lines.size());
+    for(UInt file = 1; file < files; ++file)
+    {
+        UInt words = 0;
+        if(file < covered_lines.size())
+            words = covered_lines[file].size();
+        if(file < known_lines.size())
+            words = std::max(words, (UInt)known_lines[file].size());
+        for(UInt line = 1; line < words * 64; ++line)
+        {
+            bool covered = testBit(covered_lines, file, line);
+            if(covered || testBit(known_lines, file, line))
+                func(file, line, covered);
+        }
+    }
+}
+
+struct CoverageToGAP
+{
+    Obj result;
+    Obj lines;
+    UInt file;
+
+    void operator()(UInt f, UInt line, bool covered)
+    {
+        if(!covered)
+            return;
+        if(f != file)
+        {
+            file = f;
+            lines = NEW_PLIST(T_PLIST, 0);
+            Obj pair = NEW_PLIST(T_PLIST, 2);
+            PushPlist(pair, GetCachedFilename(file));
+            PushPlist(pair, lines);
+            PushPlist(result, pair);
+        }
+        PushPlist(lines, INTOBJ_INT(line));
+    }
+};
+
+static Obj FuncGET_COVERAGE(Obj self)
+{
+    CoverageToGAP out;
+    out.result = NEW_PLIST(T_PLIST, 0);
+    out.lines = 0;
+    out.file = 0;
+    forEachLine<CoverageToGAP&>(out);
+    return out.result;
+}
+
+// Writes one lcov record per file. Files whose name is not known are
+// skipped.
+struct CoverageToLcov
+{
+    FILE* out;
+    UInt file;
+    bool skip;
+    UInt found;
+    UInt hit;
+    UInt records;
+
+    void endRecord()
+    {
+        if(file == 0 || skip)
+            return;
+        fprintf(out, "LF:%lu\nLH:%lu\nend_of_record\n",
+                (unsigned long)found, (unsigned long)hit);
+        records++;
+    }
+
+    void operator()(UInt f, UInt line, bool covered)
+    {
+        if(f != file)
+        {
+            endRecord();
+            file = f;
+            found = 0;
+            hit = 0;
+            Obj filename = GetCachedFilename(file);
+            skip = !filename || !IS_STRING_REP(filename);
+            if(skip)
+                return;
+            const char* name = CONST_CSTR_STRING(filename);
+            char path[PATH_MAX];
+            if(realpath(name, path))
+                name = path;
+            fprintf(out, "TN:\nSF:%s\n", name);
+        }
+        if(skip)
+            return;
+        fprintf(out, "DA:%lu,%d\n", (unsigned long)line, covered ? 1 : 0);
+        found++;
+        if(covered)
+            hit++;
+    }
+};
+
+static Obj FuncWRITE_LCOV(Obj self, Obj filename)
+{
+    if(!IS_STRING_REP(filename))
+    {
+        ErrorMayQuit("Usage: WriteLcov(filename)",0,0);
+    }
+    FILE* out = fopen(CONST_CSTR_STRING(filename), "w");
+    if(!out)
+    {
+        ErrorMayQuit("Unable to open '%s'", (Int)CONST_CSTR_STRING(filename),0);
+    }
+    CoverageToLcov lcov = { out, 0, false, 0, 0, 0 };
+    forEachLine<CoverageToLcov&>(lcov);
+    lcov.endRecord();
+    if(fclose(out) != 0)
+    {
+        ErrorMayQuit("Error writing '%s'", (Int)CONST_CSTR_STRING(filename),0);
+    }
+    return INTOBJ_INT(lcov.records);
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(START_COVERAGE, 0, ""),
+    GVAR_FUNC(STOP_COVERAGE, 0, ""),
+    GVAR_FUNC(CLEAR_COVERAGE, 0, ""),
+    GVAR_FUNC(GET_COVERAGE, 0, ""),
+    GVAR_FUNC(WRITE_LCOV, 1, "filename"),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelCoverage()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    return 0;
+}
+
+Int InitLibraryCoverage()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    return 0;
+}
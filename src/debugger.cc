@@ -7,19 +7,105 @@ extern "C" {
 #include "hookintrprtr.h"
 }
 
+#include "debugger.h"
 #include "gap_cpp_headers/gap_cpp_mapping.hpp"
+#include "breakpoint_index.hpp"
+#include "filename_index.hpp"
+#include "variables.hpp"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <utility>
 
 // List of break points
 std::vector<std::pair<Int, Int> > break_points;
 
+// Index of break_points, for fast lookup by location
+BreakpointIndex breakpoint_index;
+
+// Conditions which are checked natively before calling a breakpoint's
+// function, so breakpoints which do not fire never run any GAP code.
+struct BreakpointCondition
+{
+    enum Compare { None, Equals, AtLeast };
+
+    // Number of times the breakpoint's location has been reached
+    UInt hits;
+    // Do not fire for the first 'ignore' hits
+    UInt ignore;
+    // After that, fire on every 'every'th hit
+    UInt every;
+    // Only fire if 'variable' is a small integer which compares with
+    // 'value' using 'compare'
+    VariableRef variable;
+    Compare compare;
+    Int value;
+    // If not 0, the id of the history (see history.cc) which records the
+    // breakpoint firing, instead of calling its function
+    Int history;
+
+    BreakpointCondition()
+    : hits(0), ignore(0), every(1), compare(None), value(0), history(0)
+    { }
+
+    // Record a hit, and check if the breakpoint should fire
+    bool hit()
+    {
+        hits++;
+        if(hits <= ignore || (hits - ignore) % every != 0)
+            return false;
+        if(compare == None)
+            return true;
+        Obj val = variable.read();
+        if(!val || !IS_INTOBJ(val))
+            return false;
+        if(compare == Equals)
+            return INT_INTOBJ(val) == value;
+        return INT_INTOBJ(val) >= value;
+    }
+};
+
+// Conditions of each breakpoint, in the same order as break_points
+std::vector<BreakpointCondition> breakpoint_conditions;
+
 // List of functions to call
 // In a GAP object so they are not GCed accidentally.
 Obj breakpoint_functions;
 
+// Index of the names of files GAP has read. It is only brought up to date
+// when we need to search it, or a file with a new id runs while there are
+// pending breakpoints.
+FilenameIndex filename_index;
+
+// Breakpoints on files which had not been read when they were added.
+// When a file whose name ends with 'suffix' first runs, they become
+// normal breakpoints.
+struct PendingBreakpoint
+{
+    std::string suffix;
+    Int line;
+    BreakpointCondition cond;
+};
+
+std::vector<PendingBreakpoint> pending_breakpoints;
+
+// Functions of the pending breakpoints, in the same order
+Obj pending_breakpoint_functions;
+
+// Breakpoints on entering particular functions. The functions, and the
+// function to call for each, are stored in GAP lists so they are not GCed.
+// function_breakpoint_index maps each function to its position in these
+// lists, so checking a function costs one hash lookup. An Obj stays the
+// same when GAP moves the bag it refers to, so it can be used as a key.
+Obj function_breakpoint_targets;
+Obj function_breakpoint_callbacks;
+std::unordered_map<Obj, Int> function_breakpoint_index;
+
 // Function to call whenever moving to a new statement.
 Obj every_step_function;
 
@@ -38,6 +124,41 @@ Obj every_leave_function;
 // Function to call next time leaving a function.
 Obj next_leave_function;
 
+// Native stepping. We only call 'step_function' (with the file and line)
+// once the stopping condition is reached. Stepping is relative to the
+// frame (the local variables bag) of the function the debugger last
+// stopped in. We compare frames rather than counting functions entered and
+// left, as the break loop and the functions it runs are not seen by our
+// hooks, but leaving them is.
+enum StepMode { StepNone, StepOverMode, StepOutMode, StepLinesMode };
+static StepMode step_mode;
+static Obj step_frame;
+// The frame running when the debugger last stopped
+static Obj stopped_frame;
+// For StepLinesMode, the number of new lines still to run
+static UInt step_count;
+// For StepOverMode, where stepping started
+static std::pair<Int, Int> step_start;
+Obj step_function;
+
+
+// A small cache, indexed by function body, which stores the file id of
+// the body and if it contains any breakpoints. This lets debugVisitStat
+// skip statements in functions with no breakpoints after a single pointer
+// comparison. The bodies are stored in a GAP list so they cannot be garbage
+// collected while in the cache, and then replaced by a different body at
+// the same address.
+#define BODY_CACHE_SIZE 64
+
+struct BodyCacheEntry
+{
+    Int file;
+    bool has_breakpoints;
+    UInt generation;
+};
+
+static Obj body_cache;
+static BodyCacheEntry body_cache_entries[BODY_CACHE_SIZE];
 
 // The last location -- so we do not keep triggering on the same line.
 static std::pair<Int, Int> prevlocation;
@@ -45,34 +166,72 @@ static std::pair<Int, Int> prevlocation;
 // Checks if we are currently inside a function called by the debugger,
 // or inside the break loop, so we should not invoke any more debugging
 // functions, to avoid infinite loops.
-static Int disable_debugger;
+Int disable_debugger;
 
 
 // If GAP ever longjmps, let's re-enable the debugger. This isn't perfect,
 // but stops the debugger apparently dying.
 extern "C" {
 void resetDebuggerOnThrow(int depth)
-{ disable_debugger = 0; }
+{
+    disable_debugger = 0;
+    // The function we were stepping in has usually been left, so stop
+    step_mode = StepNone;
+    step_function = 0;
+    step_frame = 0;
+    funcProfileReset();
+    allocProfileReset();
+    shadowStackReset();
+    chromeTraceReset();
+}
 
 void resetDebuggerOnBreakLoop(Int i)
 { disable_debugger = i; }
 }
 
-static Obj FuncACTIVATE_DEBUGGING(Obj self);
-static Obj FuncDEACTIVATE_DEBUGGING(Obj self);
+// Each hook is specialised for the groups of features which are active,
+// so only the code for those groups is compiled into it, and a hook is
+// only installed when some feature needs it.
+enum HookFeatures {
+    // Breakpoints and stepping, checked on each new line
+    HookStatBreak = 1,
+    // Native recording of each statement (profilers, traces, coverage,
+    // watchpoints and the heap tripwire)
+    HookStatRecord = 2,
+    // Functions called on entering and leaving functions, and stepping
+    HookCallBreak = 4,
+    // Native recording of function calls
+    HookCallRecord = 8,
+    HookStatFeatures = HookStatBreak | HookStatRecord,
+    HookCallFeatures = HookCallBreak | HookCallRecord,
+    HookAllFeatures = HookStatFeatures | HookCallFeatures
+};
+
+static void installFeatureHooks(int features);
 
-// Check if we should enable or disable hooks
-// TODO: Improve, error checking
+// Install the hooks needed by the features which are active, or remove
+// our hooks if nothing is active
 void ConsiderEnableDisableDebugging()
 {
-    bool breakpoint = (!break_points.empty() ||
-                        every_step_function || next_step_function ||
-                        every_enter_function || next_enter_function ||
-                        every_leave_function || next_leave_function);
-    if(breakpoint)
-        FuncACTIVATE_DEBUGGING(0);
-    else
-        FuncDEACTIVATE_DEBUGGING(0);
+    int features = 0;
+    if(!break_points.empty() || !pending_breakpoints.empty() ||
+       every_step_function || next_step_function || step_mode != StepNone)
+        features |= HookStatBreak;
+    if(line_profile_active || alloc_profile_active || shared_profile_active ||
+       coverage_active || sample_profile_active || event_trace_active ||
+       trace_file_active || checkpoint_active || logpoint_active ||
+       watch_active || heap_growth_active || shadow_stack_active)
+        features |= HookStatRecord;
+    if(!function_breakpoint_index.empty() ||
+       every_enter_function || next_enter_function ||
+       every_leave_function || next_leave_function)
+        features |= HookCallBreak;
+    if(func_profile_active || alloc_profile_active || shared_profile_active ||
+       sample_profile_active || event_trace_active || trace_file_active ||
+       chrome_trace_active || watch_active || shadow_stack_active ||
+       logpoint_active)
+        features |= HookCallRecord;
+    installFeatureHooks(features);
 }
 
 // Call a function, suspending debugging while it runs
@@ -97,14 +256,230 @@ static void callDebugFunction2(Obj funcobj, Obj val1, Obj val2)
     disable_debugger = 0;
 }
 
-void debugVisitStat(Stat stat)
+static void addBreakpoint(Int file, Int line, Obj func,
+                          const BreakpointCondition& cond)
+{
+    break_points.push_back(std::pair<Int, Int>(file, line));
+    breakpoint_conditions.push_back(cond);
+    Int breaklen = break_points.size();
+    breakpoint_index.add(file, line, breaklen - 1);
+    GROW_PLIST(breakpoint_functions, breaklen);
+    SET_LEN_PLIST(breakpoint_functions, breaklen);
+    SET_ELM_PLIST(breakpoint_functions, breaklen, func);
+    CHANGED_BAG(breakpoint_functions);
+}
+
+// Add a breakpoint on files read from now on whose name ends with 'suffix'
+static void addPendingBreakpoint(const char* suffix, Int line, Obj func,
+                                 const BreakpointCondition& cond)
+{
+    PendingBreakpoint p;
+    p.suffix = suffix;
+    p.line = line;
+    p.cond = cond;
+    pending_breakpoints.push_back(p);
+    PushPlist(pending_breakpoint_functions, func);
+}
+
+// Free the histories of breakpoints which have been removed
+static void releaseUnusedHistories()
+{
+    std::vector<Int> ids;
+    for(UInt i = 0; i < breakpoint_conditions.size(); ++i)
+        if(breakpoint_conditions[i].history)
+            ids.push_back(breakpoint_conditions[i].history);
+    for(UInt i = 0; i < pending_breakpoints.size(); ++i)
+        if(pending_breakpoints[i].cond.history)
+            ids.push_back(pending_breakpoints[i].cond.history);
+    keepBreakpointHistories(ids);
+}
+
+// Turns pending breakpoints on the files with ids from 'first' to 'last'
+// into normal breakpoints
+static void resolvePendingBreakpoints(Int first, Int last)
+{
+    UInt kept = 0;
+    for(UInt i = 0; i < pending_breakpoints.size(); ++i)
+    {
+        const PendingBreakpoint& p = pending_breakpoints[i];
+        Obj func = ELM_PLIST(pending_breakpoint_functions, i + 1);
+        bool resolved = false;
+        for(Int id = first; id <= last; ++id)
+        {
+            Obj name = GetCachedFilename(id);
+            if(name && IS_STRING_REP(name) &&
+               FilenameIndex::endsWith(CONST_CSTR_STRING(name), p.suffix))
+            {
+                addBreakpoint(id, p.line, func, p.cond);
+                resolved = true;
+            }
+        }
+        if(!resolved)
+        {
+            pending_breakpoints[kept] = p;
+            SET_ELM_PLIST(pending_breakpoint_functions, kept + 1, func);
+            kept++;
+        }
+    }
+    pending_breakpoints.resize(kept);
+    SET_LEN_PLIST(pending_breakpoint_functions, kept);
+    CHANGED_BAG(pending_breakpoint_functions);
+}
+
+// Add the names of file ids up to 'last' to filename_index. Every file is
+// added exactly once, so this is also where pending breakpoints on new
+// files are resolved.
+static void addNewFilenames(Int last)
+{
+    Int first = filename_index.knownFiles() + 1;
+    for(Int id = first; id <= last; ++id)
+    {
+        Obj name = GetCachedFilename(id);
+        filename_index.add((name && IS_STRING_REP(name)) ? CONST_CSTR_STRING(name) : "");
+    }
+    if(first <= last && !pending_breakpoints.empty())
+        resolvePendingBreakpoints(first, last);
+}
+
+// GAP's own list of filenames, if we can find it. GET_FILENAME_CACHE
+// returns a copy, which takes time proportional to the number of files
+// read, so we only use it when we cannot read the length directly.
+static Bag* filename_cache;
+
+static void findFilenameCache()
+{
+#ifdef USE_GASMAN
+    const char* cookies[] = { "src/io.c:FilenameCache", "FilenameCache" };
+    for(UInt i = 0; i < 2 && !filename_cache; ++i)
+    {
+        Bag* addr = GlobalByCookie(cookies[i]);
+        if(addr && *addr && IS_PLIST(*addr))
+            filename_cache = addr;
+    }
+#endif
+}
+
+// The number of files GAP has read
+static Int filenameCount()
+{
+    if(filename_cache)
+        return LEN_PLIST(*filename_cache);
+    Obj cache = CALL_0ARGS(VAL_GVAR(GVarName("GET_FILENAME_CACHE")));
+    return LEN_LIST(cache);
+}
+
+static void syncFilenameIndex()
+{
+    addNewFilenames(filenameCount());
+}
+
+static const BodyCacheEntry& lookupBodyCache(Obj body)
+{
+    UInt slot = ((UInt)body / sizeof(Obj)) % BODY_CACHE_SIZE;
+    BodyCacheEntry& entry = body_cache_entries[slot];
+    if(ELM_PLIST(body_cache, slot + 1) != body ||
+       entry.generation != breakpoint_index.generation())
+    {
+        entry.file = GET_GAPNAMEID_BODY(body);
+        // Called when a file with an id we have not seen before runs
+        if(!pending_breakpoints.empty() && entry.file > filename_index.knownFiles())
+            addNewFilenames(entry.file);
+        entry.has_breakpoints =
+            breakpoint_index.containsRange(entry.file,
+                                           GET_STARTLINE_BODY(body),
+                                           GET_ENDLINE_BODY(body));
+        entry.generation = breakpoint_index.generation();
+        SET_ELM_PLIST(body_cache, slot + 1, body);
+        CHANGED_BAG(body_cache);
+    }
+    return entry;
+}
+
+// Is 'frame' the running function, or one of the functions which called it
+static bool frameRunning(Obj frame)
+{
+    for(Obj lvars = STATE(CurrLVars); !IsBottomLVars(lvars); lvars = PARENT_LVARS(lvars))
+    {
+        if(lvars == frame)
+            return true;
+    }
+    return false;
+}
+
+// Called on each new line while stepping
+static bool stepFinished(const std::pair<Int, Int>& location)
+{
+    switch(step_mode)
+    {
+    case StepOverMode:
+        if(STATE(CurrLVars) == step_frame)
+            return location != step_start;
+        return !frameRunning(step_frame);
+    case StepOutMode:
+        return !frameRunning(step_frame);
+    case StepLinesMode:
+        return --step_count == 0;
+    default:
+        return false;
+    }
+}
+
+template<int Features>
+static void debugVisitStat(Stat stat)
 {
     if(disable_debugger)
         return;
 
-    Obj func = CURR_FUNC();
-    Obj body = BODY_FUNC(func);
-    Int file = GET_GAPNAMEID_BODY(body);
+    Obj body = BODY_FUNC(CURR_FUNC());
+    const BodyCacheEntry& entry = lookupBodyCache(body);
+    if(Features & HookStatRecord)
+    {
+        if(sample_pending)
+            samplingTakeSample(LINE_STAT(stat));
+        if(shadow_stack_active)
+            shadowStackVisitStat(entry.file, LINE_STAT(stat));
+        if(coverage_active)
+            coverageVisitStat(entry.file, LINE_STAT(stat));
+        if(line_profile_active || alloc_profile_active || shared_profile_active ||
+           event_trace_active || checkpoint_active || trace_file_active ||
+           logpoint_active)
+        {
+            Int line = LINE_STAT(stat);
+            if(entry.file != 0 && line != 0)
+            {
+                if(line_profile_active)
+                    lineProfileVisitStat(entry.file, line);
+                if(alloc_profile_active)
+                    allocProfileVisitStat(entry.file, line);
+                if(shared_profile_active)
+                    sharedProfileVisitStat(entry.file, line);
+                if(event_trace_active)
+                    eventTraceVisitStat(body, entry.file, line);
+                // Before the trace file, which it may start or stop
+                if(checkpoint_active)
+                    checkpointVisitStat(entry.file, line);
+                if(trace_file_active)
+                    traceFileVisitStat(entry.file, line);
+                if(logpoint_active)
+                    logpointVisitStat(entry.file, line);
+            }
+        }
+        if(watch_active)
+            watchVisitStat(entry.file, LINE_STAT(stat));
+        if(heap_growth_active)
+            heapGrowthCheck(entry.file, LINE_STAT(stat));
+    }
+    if(!(Features & HookStatBreak))
+        return;
+
+    if(!entry.has_breakpoints && !next_step_function && !every_step_function &&
+       step_mode == StepNone)
+    {
+        // No location in this body can match prevlocation
+        prevlocation = std::pair<Int, Int>(0, 0);
+        return;
+    }
+    Int file = entry.file;
 
     Int line = LINE_STAT(stat);
     // skip if not valid
@@ -114,6 +489,7 @@ void debugVisitStat(Stat stat)
     // Check we have moved line
     if(prevlocation == location)
         return;
+    stopped_frame = STATE(CurrLVars);
     if(next_step_function)
     {
         Obj store = next_step_function;
@@ -122,58 +498,341 @@ void debugVisitStat(Stat stat)
     }
     if(every_step_function)
         callDebugFunction2(every_step_function, INTOBJ_INT(file), INTOBJ_INT(line));
+    if(step_mode != StepNone && stepFinished(location))
+    {
+        Obj store = step_function;
+        step_mode = StepNone;
+        step_function = 0;
+        ConsiderEnableDisableDebugging();
+        if(shadow_stack_active)
+            shadowStackCapture();
+        callDebugFunction2(store, INTOBJ_INT(file), INTOBJ_INT(line));
+    }
     prevlocation = location;
 
-    bool hit = false;
-    for(int i = 0; i < break_points.size(); ++i)
+    const std::vector<Int>* hits = breakpoint_index.find(file, line);
+    if(!hits)
+        return;
+    // Take a copy, as the called functions may add or remove breakpoints
+    std::vector<Int> positions(*hits);
+    for(UInt i = 0; i < positions.size(); ++i)
     {
-        if(break_points[i] == location)
+        Int pos = positions[i];
+        if((UInt)pos < break_points.size() && break_points[pos] == location &&
+           breakpoint_conditions[pos].hit())
         {
-            hit = true;
-            callDebugFunction0(ELM_PLIST(breakpoint_functions, i+1));
+            if(breakpoint_conditions[pos].history)
+            {
+                breakpointHistoryRecord(breakpoint_conditions[pos].history,
+                                        breakpoint_conditions[pos].hits);
+                continue;
+            }
+            if(shadow_stack_active)
+                shadowStackCapture();
+            callDebugFunction0(ELM_PLIST(breakpoint_functions, pos+1));
         }
     }
 }
 
-void debugEnterFunction(Obj func)
+template<int Features>
+static void debugEnterFunction(Obj func)
 {
-    if(next_enter_function && !disable_debugger)
+    if(disable_debugger)
+        return;
+
+    if(Features & HookCallRecord)
+    {
+        if(sample_pending)
+            samplingTakeSample(0);
+        if(shadow_stack_active)
+            shadowStackEnter(func);
+        if(func_profile_active)
+            funcProfileEnter(func);
+        if(alloc_profile_active)
+            allocProfileEnter(func);
+        if(shared_profile_active)
+            sharedProfileEnter(func);
+        if(event_trace_active)
+            eventTraceEnter(func);
+        if(trace_file_active)
+            traceFileEnter(func);
+        if(chrome_trace_active)
+            chromeTraceEnter(func);
+        if(logpoint_active)
+            logpointEnterFunction();
+    }
+    if(Features & HookCallBreak)
     {
-        Obj store = next_enter_function;
-        next_enter_function = 0;
-        callDebugFunction1(next_enter_function, func);
+        if(next_enter_function)
+        {
+            Obj store = next_enter_function;
+            next_enter_function = 0;
+            callDebugFunction1(store, func);
+        }
+        if(!function_breakpoint_index.empty())
+        {
+            std::unordered_map<Obj, Int>::const_iterator it =
+                function_breakpoint_index.find(func);
+            if(it != function_breakpoint_index.end())
+            {
+                stopped_frame = STATE(CurrLVars);
+                if(shadow_stack_active)
+                    shadowStackCapture();
+                callDebugFunction1(ELM_PLIST(function_breakpoint_callbacks, it->second), func);
+            }
+        }
+        if(every_enter_function)
+            callDebugFunction1(every_enter_function, func);
     }
-    if(every_enter_function && !disable_debugger)
-        callDebugFunction1(every_enter_function, func);
 }
 
-void debugLeaveFunction(Obj func)
+template<int Features>
+static void debugLeaveFunction(Obj func)
 {
-    if(next_leave_function && !disable_debugger)
+    if(disable_debugger)
+        return;
+
+    if(Features & HookCallRecord)
+    {
+        if(func_profile_active)
+            funcProfileLeave(func);
+        if(alloc_profile_active)
+            allocProfileLeave(func);
+        if(event_trace_active)
+            eventTraceLeave(func);
+        if(trace_file_active)
+            traceFileLeave(func);
+        if(chrome_trace_active)
+            chromeTraceLeave(func);
+        if(watch_active)
+            watchLeaveFunction();
+        if(shadow_stack_active)
+            shadowStackLeave(func);
+    }
+    if(Features & HookCallBreak)
     {
-        Obj store = next_leave_function;
-        next_leave_function = 0;
-        callDebugFunction1(next_leave_function, func);
+        if(next_leave_function)
+        {
+            Obj store = next_leave_function;
+            next_leave_function = 0;
+            callDebugFunction1(store, func);
+        }
+        if(every_leave_function)
+            callDebugFunction1(every_leave_function, func);
     }
-    if(every_leave_function && !disable_debugger)
-        callDebugFunction1(every_leave_function, func);
 }
 
+#if GAP_KERNEL_MAJOR_VERSION >= 6
+// Statements read outside of functions, which are only used for coverage
+static void debugVisitInterpretedStat(Int file, Int line)
+{
+    if(coverage_active && !disable_debugger)
+        coverageVisitStat(file, line);
+}
 
-static Obj FuncADD_BREAKPOINT(Obj self, Obj objfile, Obj objline, Obj func)
+// Called as GAP reads each statement
+static void debugRegisterStat(Int file, Int line, Int type)
 {
-    Int intfile = INT_INTOBJ(objfile);
-    Int intline = INT_INTOBJ(objline);
-    break_points.push_back(std::pair<Int, Int>(intfile, intline));
-    Int breaklen = break_points.size();
-    GROW_PLIST(breakpoint_functions, breaklen);
-    SET_LEN_PLIST(breakpoint_functions, breaklen);
-    SET_ELM_PLIST(breakpoint_functions, breaklen, func);
-    CHANGED_BAG(breakpoint_functions);
+    if(coverage_active && !disable_debugger)
+        coverageRegisterStat(file, line);
+}
+
+static void debugRegisterInterpretedStat(Int file, Int line)
+{
+    if(coverage_active && !disable_debugger)
+        coverageRegisterStat(file, line);
+}
+#endif
+
+
+// Read a non-negative small integer from an options record, or return
+// 'def' if it is not present.
+static UInt GetOptionCount(Obj options, const char* name, UInt def)
+{
+    UInt rnam = RNamName(name);
+    if(!ISB_REC(options, rnam))
+        return def;
+    Obj val = ELM_REC(options, rnam);
+    if(!IS_NONNEG_INTOBJ(val))
+    {
+        ErrorMayQuit("Breakpoint option '%s' must be a non-negative integer",
+                     (Int)name, 0);
+    }
+    return INT_INTOBJ(val);
+}
+
+static BreakpointCondition ReadBreakpointCondition(Obj options)
+{
+    BreakpointCondition cond;
+    if(!IS_REC(options))
+    {
+        ErrorMayQuit("Breakpoint options must be a record",0,0);
+    }
+    cond.ignore = GetOptionCount(options, "ignore", 0);
+    cond.every = GetOptionCount(options, "every", 1);
+    if(cond.every == 0)
+    {
+        ErrorMayQuit("Breakpoint option 'every' must be positive",0,0);
+    }
+
+    UInt rvariable = RNamName("variable");
+    UInt requals = RNamName("equals");
+    UInt ratleast = RNamName("atLeast");
+    if(ISB_REC(options, rvariable))
+    {
+        Obj name = ELM_REC(options, rvariable);
+        if(!IS_STRING(name) || !IS_STRING_REP(name))
+        {
+            ErrorMayQuit("Breakpoint option 'variable' must be a string",0,0);
+        }
+        cond.variable = VariableRef(CONST_CSTR_STRING(name));
+        Obj val;
+        if(ISB_REC(options, requals) && !ISB_REC(options, ratleast))
+        {
+            cond.compare = BreakpointCondition::Equals;
+            val = ELM_REC(options, requals);
+        }
+        else if(ISB_REC(options, ratleast) && !ISB_REC(options, requals))
+        {
+            cond.compare = BreakpointCondition::AtLeast;
+            val = ELM_REC(options, ratleast);
+        }
+        else
+        {
+            ErrorMayQuit("Breakpoint option 'variable' needs exactly one of "
+                         "'equals' or 'atLeast'",0,0);
+            return cond;
+        }
+        if(!IS_INTOBJ(val))
+        {
+            ErrorMayQuit("Breakpoints can only compare against small integers",0,0);
+        }
+        cond.value = INT_INTOBJ(val);
+    }
+    else if(ISB_REC(options, requals) || ISB_REC(options, ratleast))
+    {
+        ErrorMayQuit("Breakpoint option 'variable' must be given",0,0);
+    }
+    return cond;
+}
+
+// Read 'options', creating a history for the breakpoint if they ask for
+// one
+static BreakpointCondition NewBreakpointCondition(Obj options)
+{
+    BreakpointCondition cond = ReadBreakpointCondition(options);
+    cond.history = newBreakpointHistory(options);
+    return cond;
+}
+
+static Obj FuncADD_BREAKPOINT(Obj self, Obj args)
+{
+    if(LEN_PLIST(args) != 3 && LEN_PLIST(args) != 4)
+    {
+        ErrorMayQuit("Usage: ADD_BREAKPOINT(file, line, func[, options])",0,0);
+    }
+    Obj objfile = ELM_PLIST(args, 1);
+    Obj objline = ELM_PLIST(args, 2);
+    Obj func = ELM_PLIST(args, 3);
+    BreakpointCondition cond;
+    if(LEN_PLIST(args) == 4)
+        cond = NewBreakpointCondition(ELM_PLIST(args, 4));
+
+    addBreakpoint(INT_INTOBJ(objfile), INT_INTOBJ(objline), func, cond);
     ConsiderEnableDisableDebugging();
     return 0;
 }
 
+// Returns [id, filename] for all files whose name ends with 'fileend'
+static Obj FuncFIND_FILE_IDS(Obj self, Obj fileend)
+{
+    if(!IS_STRING_REP(fileend))
+    {
+        ErrorMayQuit("Filename must be a string",0,0);
+    }
+    syncFilenameIndex();
+    std::vector<Int> ids = filename_index.find(CONST_CSTR_STRING(fileend));
+    Obj list = NEW_PLIST(T_PLIST, ids.size());
+    for(UInt i = 0; i < ids.size(); ++i)
+    {
+        Obj name = GetCachedFilename(ids[i]);
+        if(!name || !IS_STRING_REP(name))
+            continue;
+        Obj pair = NEW_PLIST(T_PLIST, 2);
+        SET_LEN_PLIST(pair, 2);
+        SET_ELM_PLIST(pair, 1, INTOBJ_INT(ids[i]));
+        SET_ELM_PLIST(pair, 2, name);
+        CHANGED_BAG(pair);
+        PushPlist(list, pair);
+    }
+    return list;
+}
+
+static Obj FuncADD_PENDING_BREAKPOINT(Obj self, Obj args)
+{
+    if(LEN_PLIST(args) != 3 && LEN_PLIST(args) != 4)
+    {
+        ErrorMayQuit("Usage: ADD_PENDING_BREAKPOINT(fileend, line, func[, options])",0,0);
+    }
+    Obj fileend = ELM_PLIST(args, 1);
+    Obj line = ELM_PLIST(args, 2);
+    if(!IS_STRING_REP(fileend) || !IS_POS_INTOBJ(line))
+    {
+        ErrorMayQuit("Usage: ADD_PENDING_BREAKPOINT(fileend, line, func[, options])",0,0);
+    }
+    BreakpointCondition cond;
+    if(LEN_PLIST(args) == 4)
+        cond = NewBreakpointCondition(ELM_PLIST(args, 4));
+    // Files which already exist do not resolve the breakpoint
+    syncFilenameIndex();
+    addPendingBreakpoint(CONST_CSTR_STRING(fileend), INT_INTOBJ(line),
+                         ELM_PLIST(args, 3), cond);
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncCLEAR_PENDING_BREAKPOINT(Obj self, Obj fileend, Obj line)
+{
+    if(!IS_STRING_REP(fileend) || !IS_INTOBJ(line))
+        return False;
+    Obj removed = False;
+    UInt kept = 0;
+    for(UInt i = 0; i < pending_breakpoints.size(); ++i)
+    {
+        const PendingBreakpoint& p = pending_breakpoints[i];
+        if(p.line == INT_INTOBJ(line) && p.suffix == CONST_CSTR_STRING(fileend))
+        {
+            removed = True;
+            continue;
+        }
+        pending_breakpoints[kept] = p;
+        SET_ELM_PLIST(pending_breakpoint_functions, kept + 1,
+                      ELM_PLIST(pending_breakpoint_functions, i + 1));
+        kept++;
+    }
+    pending_breakpoints.resize(kept);
+    SET_LEN_PLIST(pending_breakpoint_functions, kept);
+    CHANGED_BAG(pending_breakpoint_functions);
+    releaseUnusedHistories();
+    ConsiderEnableDisableDebugging();
+    return removed;
+}
+
+static Obj FuncGET_PENDING_BREAKPOINTS(Obj self)
+{
+    Obj list = NEW_PLIST(T_PLIST, pending_breakpoints.size());
+    for(UInt i = 0; i < pending_breakpoints.size(); ++i)
+    {
+        Obj pair = NEW_PLIST(T_PLIST, 2);
+        SET_LEN_PLIST(pair, 2);
+        SET_ELM_PLIST(pair, 1, MakeImmString(pending_breakpoints[i].suffix.c_str()));
+        SET_ELM_PLIST(pair, 2, INTOBJ_INT(pending_breakpoints[i].line));
+        CHANGED_BAG(pair);
+        PushPlist(list, pair);
+    }
+    return list;
+}
+
 // We do this at the C level rather than GAP, as this function is used when
 // people are enabling, or disabling breakpoints, so we want to run as little
 // GAP as possible!
@@ -227,38 +886,405 @@ static Obj FuncSET_EVERY_LEAVE_FUNCTION_BREAKPOINT(Obj self, Obj func)
 { return SetValue(&every_leave_function, func, "BREAKPOINT_DEFAULT_FUNCTION"); }
 
 
+static uint64_t locationKey(Int file, Int line)
+{ return ((uint64_t)file << 32) ^ (uint64_t)line; }
+
+// Remove every breakpoint whose location is in 'locations', in a single
+// pass over the breakpoints. Returns the number removed.
+static UInt removeBreakpoints(const std::unordered_set<uint64_t>& locations)
+{
+    UInt kept = 0;
+    for(UInt i = 0; i < break_points.size(); ++i)
+    {
+        if(locations.count(locationKey(break_points[i].first, break_points[i].second)))
+            continue;
+        if(kept != i)
+        {
+            break_points[kept] = break_points[i];
+            breakpoint_conditions[kept] = breakpoint_conditions[i];
+            SET_ELM_PLIST(breakpoint_functions, kept + 1,
+                          ELM_PLIST(breakpoint_functions, i + 1));
+        }
+        kept++;
+    }
+    UInt removed = break_points.size() - kept;
+    if(removed == 0)
+        return 0;
+    for(UInt i = kept; i < break_points.size(); ++i)
+        SET_ELM_PLIST(breakpoint_functions, i + 1, 0);
+    break_points.resize(kept);
+    breakpoint_conditions.resize(kept);
+    SET_LEN_PLIST(breakpoint_functions, kept);
+    CHANGED_BAG(breakpoint_functions);
+    breakpoint_index.rebuild(break_points);
+    releaseUnusedHistories();
+    return removed;
+}
+
+// Start stepping in 'mode'. 'args' is the optional function to call when
+// stepping finishes (by default entering the break loop), or fail to
+// stop stepping.
+static Obj StartStepping(StepMode mode, Obj args, UInt count)
+{
+    Obj func = 0;
+    SetValue(&func, args, "BREAKPOINT_DEFAULT_FILELINE");
+    step_function = func;
+    step_mode = func ? mode : StepNone;
+    step_frame = stopped_frame;
+    step_count = count;
+    step_start = prevlocation;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncSTEP_OVER(Obj self, Obj args)
+{ return StartStepping(StepOverMode, args, 0); }
+
+static Obj FuncSTEP_OUT(Obj self, Obj args)
+{ return StartStepping(StepOutMode, args, 0); }
+
+static Obj FuncSTEP_LINES(Obj self, Obj args)
+{
+    if(LEN_PLIST(args) == 0 || !IS_POS_INTOBJ(ELM_PLIST(args, 1)))
+    {
+        ErrorMayQuit("Usage: StepLines(n[, func]), where n is a positive integer",0,0);
+    }
+    UInt count = INT_INTOBJ(ELM_PLIST(args, 1));
+    Obj rest = NEW_PLIST(T_PLIST, LEN_PLIST(args) - 1);
+    for(Int i = 2; i <= LEN_PLIST(args); ++i)
+        PushPlist(rest, ELM_PLIST(args, i));
+    return StartStepping(StepLinesMode, rest, count);
+}
+
 static Obj FuncCLEAR_BREAKPOINT(Obj self, Obj objfile, Obj objline)
 {
-    Int intfile = INT_INTOBJ(objfile);
-    Int intline = INT_INTOBJ(objline);
-    std::pair<Int, Int> location(intfile, intline);
+    std::unordered_set<uint64_t> locations;
+    locations.insert(locationKey(INT_INTOBJ(objfile), INT_INTOBJ(objline)));
+    Obj removed = removeBreakpoints(locations) ? True : False;
+    ConsiderEnableDisableDebugging();
+    return removed;
+}
 
-    Obj removed = False;
+// Add a list of breakpoints, each [fileend, line, func] or
+// [fileend, line, func, options]. Each entry is added to every file whose
+// name ends with 'fileend', or is made pending if there are none. All
+// entries are checked before any are added, so an error leaves the
+// breakpoints unchanged.
+static Obj FuncADD_BREAKPOINTS(Obj self, Obj list)
+{
+    if(!IS_PLIST(list))
+    {
+        ErrorMayQuit("ADD_BREAKPOINTS: argument must be a list",0,0);
+    }
+    syncFilenameIndex();
+    Int len = LEN_PLIST(list);
+    std::vector<BreakpointCondition> conds(len);
+    std::vector<std::vector<Int> > files(len);
+    UInt history_slots = 0;
+    for(Int i = 1; i <= len; ++i)
+    {
+        Obj entry = ELM_PLIST(list, i);
+        if(!entry || !IS_PLIST(entry) ||
+           (LEN_PLIST(entry) != 3 && LEN_PLIST(entry) != 4) ||
+           !IS_STRING_REP(ELM_PLIST(entry, 1)) ||
+           !IS_POS_INTOBJ(ELM_PLIST(entry, 2)) ||
+           !ELM_PLIST(entry, 3) || !IS_FUNC(ELM_PLIST(entry, 3)))
+        {
+            ErrorMayQuit("ADD_BREAKPOINTS: entry %d must be "
+                         "[fileend, line, func[, options]]", i, 0);
+        }
+        files[i - 1] = filename_index.find(CONST_CSTR_STRING(ELM_PLIST(entry, 1)));
+        if(LEN_PLIST(entry) == 4)
+        {
+            conds[i - 1] = ReadBreakpointCondition(ELM_PLIST(entry, 4));
+            // Each file, or the pending breakpoint, gets its own history
+            UInt copies = files[i - 1].empty() ? 1 : files[i - 1].size();
+            history_slots += copies * breakpointHistorySlots(ELM_PLIST(entry, 4));
+            // Checked as we go, so the total cannot overflow
+            checkBreakpointHistorySlots(history_slots);
+        }
+    }
+    // Histories are only created once nothing else can fail
+    for(Int i = 1; i <= len; ++i)
+    {
+        Obj entry = ELM_PLIST(list, i);
+        Obj func = ELM_PLIST(entry, 3);
+        Int line = INT_INTOBJ(ELM_PLIST(entry, 2));
+        BreakpointCondition cond = conds[i - 1];
+        if(files[i - 1].empty())
+        {
+            if(LEN_PLIST(entry) == 4)
+                cond.history = newBreakpointHistory(ELM_PLIST(entry, 4));
+            addPendingBreakpoint(CONST_CSTR_STRING(ELM_PLIST(entry, 1)), line,
+                                 func, cond);
+        }
+        for(UInt j = 0; j < files[i - 1].size(); ++j)
+        {
+            if(LEN_PLIST(entry) == 4)
+                cond.history = newBreakpointHistory(ELM_PLIST(entry, 4));
+            addBreakpoint(files[i - 1][j], line, func, cond);
+        }
+    }
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
 
-    for(int i = 0; i < break_points.size(); ++i)
+// Remove all breakpoints at any of a list of [file, line] locations.
+// Returns the number of breakpoints removed.
+static Obj FuncCLEAR_BREAKPOINTS(Obj self, Obj list)
+{
+    if(!IS_PLIST(list))
+    {
+        ErrorMayQuit("CLEAR_BREAKPOINTS: argument must be a list",0,0);
+    }
+    std::unordered_set<uint64_t> locations;
+    for(Int i = 1; i <= LEN_PLIST(list); ++i)
     {
-        if(break_points[i] == location)
+        Obj entry = ELM_PLIST(list, i);
+        if(!entry || !IS_PLIST(entry) || LEN_PLIST(entry) != 2 ||
+           !IS_INTOBJ(ELM_PLIST(entry, 1)) || !IS_INTOBJ(ELM_PLIST(entry, 2)))
         {
-            removed = True;
-            break_points.erase(break_points.begin() + i);
-            for(int j = i+1; j < break_points.size(); ++j)
-            {
-                Obj val = ELM_PLIST(breakpoint_functions, j+1);
-                SET_ELM_PLIST(breakpoint_functions, j, val);
-            }
-            SET_LEN_PLIST(breakpoint_functions, break_points.size());
-            CHANGED_BAG(breakpoint_functions);
-            i--;
+            ErrorMayQuit("CLEAR_BREAKPOINTS: entry %d must be [file, line]", i, 0);
         }
+        locations.insert(locationKey(INT_INTOBJ(ELM_PLIST(entry, 1)),
+                                     INT_INTOBJ(ELM_PLIST(entry, 2))));
     }
+    UInt removed = removeBreakpoints(locations);
     ConsiderEnableDisableDebugging();
-    return removed;
+    return ObjInt_UInt(removed);
+}
+
+// Breakpoints are saved one per line, as
+//   line <tab> ignore <tab> every <tab> compare <tab> value <tab> variable
+//     <tab> history <tab> path
+// where compare is 0 (none), 1 (equals) or 2 (atLeast), and history is
+// empty, or 'size,copy,copyLimit,variable,...' for breakpoints which
+// record a history. Files written before histories existed have no
+// history field, and start with BREAKPOINT_FILE_HEADER_V1. Files are given
+// by their path rather than their id, as ids differ between GAP sessions.
+// Breakpoint functions cannot be saved.
+#define BREAKPOINT_FILE_HEADER "# debugger breakpoints 2\n"
+#define BREAKPOINT_FILE_HEADER_V1 "# debugger breakpoints 1"
+
+static void writeBreakpoint(FILE* out, const char* path, Int line,
+                            const BreakpointCondition& cond)
+{
+    std::string history;
+    if(cond.history)
+        history = savedBreakpointHistory(cond.history);
+    fprintf(out, "%ld\t%lu\t%lu\t%d\t%ld\t%s\t%s\t%s\n", (long)line,
+            (unsigned long)cond.ignore, (unsigned long)cond.every,
+            (int)cond.compare, (long)cond.value,
+            cond.variable.name().c_str(), history.c_str(), path);
+}
+
+static Obj FuncSAVE_BREAKPOINTS(Obj self, Obj filename)
+{
+    if(!IS_STRING_REP(filename))
+    {
+        ErrorMayQuit("Usage: SaveBreakpoints(filename)",0,0);
+    }
+    FILE* out = fopen(CONST_CSTR_STRING(filename), "w");
+    if(!out)
+    {
+        ErrorMayQuit("Unable to open '%s'", (Int)CONST_CSTR_STRING(filename),0);
+    }
+    fputs(BREAKPOINT_FILE_HEADER, out);
+    UInt count = 0;
+    for(UInt i = 0; i < break_points.size(); ++i)
+    {
+        Obj name = GetCachedFilename(break_points[i].first);
+        if(!name || !IS_STRING_REP(name))
+            continue;
+        writeBreakpoint(out, CONST_CSTR_STRING(name), break_points[i].second,
+                        breakpoint_conditions[i]);
+        count++;
+    }
+    for(UInt i = 0; i < pending_breakpoints.size(); ++i)
+    {
+        writeBreakpoint(out, pending_breakpoints[i].suffix.c_str(),
+                        pending_breakpoints[i].line, pending_breakpoints[i].cond);
+        count++;
+    }
+    if(fclose(out) != 0)
+    {
+        ErrorMayQuit("Error writing '%s'", (Int)CONST_CSTR_STRING(filename),0);
+    }
+    return ObjInt_UInt(count);
+}
+
+// Read a file written by SAVE_BREAKPOINTS, returning a list of
+// [path, line, options] entries, ready for AddBreakpoints
+static Obj FuncREAD_BREAKPOINT_FILE(Obj self, Obj filename)
+{
+    if(!IS_STRING_REP(filename))
+    {
+        ErrorMayQuit("Usage: LoadBreakpoints(filename[, func])",0,0);
+    }
+    FILE* in = fopen(CONST_CSTR_STRING(filename), "r");
+    if(!in)
+    {
+        ErrorMayQuit("Unable to open '%s'", (Int)CONST_CSTR_STRING(filename),0);
+    }
+    Obj list = NEW_PLIST(T_PLIST, 0);
+    std::string text;
+    char buf[4096];
+    Int lineno = 0;
+    bool bad = false;
+    // The number of fields before the path
+    UInt nfields = 7;
+    while(!bad && fgets(buf, sizeof(buf), in))
+    {
+        text += buf;
+        // Lines longer than buf are read in several pieces
+        if(text[text.size() - 1] != '\n' && !feof(in))
+            continue;
+        if(text[text.size() - 1] == '\n')
+            text.erase(text.size() - 1);
+        lineno++;
+        if(text.empty() || text[0] == '#')
+        {
+            if(lineno == 1 && text == BREAKPOINT_FILE_HEADER_V1)
+                nfields = 6;
+            text.clear();
+            continue;
+        }
+        // Split into the fields before the path
+        std::vector<std::string> fields;
+        size_t pos = 0;
+        while(fields.size() < nfields)
+        {
+            size_t tab = text.find('\t', pos);
+            if(tab == std::string::npos)
+                break;
+            fields.push_back(text.substr(pos, tab - pos));
+            pos = tab + 1;
+        }
+        if(fields.size() < nfields || pos >= text.size())
+        {
+            bad = true;
+            break;
+        }
+        long numbers[5];
+        for(int f = 0; f < 5 && !bad; ++f)
+        {
+            char* end;
+            numbers[f] = strtol(fields[f].c_str(), &end, 10);
+            if(fields[f].empty() || *end != 0)
+                bad = true;
+        }
+        long line = numbers[0], ignore = numbers[1], every = numbers[2];
+        long compare = numbers[3], value = numbers[4];
+        const std::string& variable = fields[5];
+        std::string path = text.substr(pos);
+        if(bad || line <= 0 || ignore < 0 || every <= 0 || compare < 0 ||
+           compare > 2 || (compare != 0) == variable.empty())
+        {
+            bad = true;
+            break;
+        }
+
+        Obj options = NEW_PREC(0);
+        if(ignore != 0)
+            AssPRec(options, RNamName("ignore"), ObjInt_UInt(ignore));
+        if(every != 1)
+            AssPRec(options, RNamName("every"), ObjInt_UInt(every));
+        if(compare != 0)
+        {
+            AssPRec(options, RNamName("variable"), MakeString(variable.c_str()));
+            AssPRec(options, RNamName(compare == 1 ? "equals" : "atLeast"),
+                    INTOBJ_INT(value));
+        }
+        if(nfields > 6 && !fields[6].empty() &&
+           !readSavedBreakpointHistory(fields[6], options))
+        {
+            bad = true;
+            break;
+        }
+        Obj entry = NEW_PLIST(T_PLIST, 3);
+        PushPlist(entry, MakeString(path.c_str()));
+        PushPlist(entry, INTOBJ_INT(line));
+        PushPlist(entry, options);
+        PushPlist(list, entry);
+        text.clear();
+    }
+    fclose(in);
+    if(bad)
+    {
+        ErrorMayQuit("Invalid breakpoint file, at line %d", lineno, 0);
+    }
+    return list;
+}
+
+static Obj FuncADD_FUNCTION_BREAKPOINT(Obj self, Obj func, Obj callback)
+{
+    if(!IS_FUNC(func) || !IS_FUNC(callback))
+    {
+        ErrorMayQuit("Usage: AddFunctionBreakpoint(func[, callback])",0,0);
+    }
+    std::unordered_map<Obj, Int>::const_iterator it =
+        function_breakpoint_index.find(func);
+    if(it != function_breakpoint_index.end())
+    {
+        // Replace the existing breakpoint
+        SET_ELM_PLIST(function_breakpoint_callbacks, it->second, callback);
+        CHANGED_BAG(function_breakpoint_callbacks);
+        return 0;
+    }
+    Int pos = PushPlist(function_breakpoint_targets, func);
+    PushPlist(function_breakpoint_callbacks, callback);
+    function_breakpoint_index[func] = pos;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncCLEAR_FUNCTION_BREAKPOINT(Obj self, Obj func)
+{
+    std::unordered_map<Obj, Int>::iterator it =
+        function_breakpoint_index.find(func);
+    if(it == function_breakpoint_index.end())
+        return False;
+    // Move the last breakpoint into the removed one's place
+    Int pos = it->second;
+    Int last = LEN_PLIST(function_breakpoint_targets);
+    function_breakpoint_index.erase(it);
+    if(pos != last)
+    {
+        Obj lastfunc = ELM_PLIST(function_breakpoint_targets, last);
+        SET_ELM_PLIST(function_breakpoint_targets, pos, lastfunc);
+        SET_ELM_PLIST(function_breakpoint_callbacks, pos,
+                      ELM_PLIST(function_breakpoint_callbacks, last));
+        CHANGED_BAG(function_breakpoint_targets);
+        CHANGED_BAG(function_breakpoint_callbacks);
+        function_breakpoint_index[lastfunc] = pos;
+    }
+    SET_ELM_PLIST(function_breakpoint_targets, last, 0);
+    SET_ELM_PLIST(function_breakpoint_callbacks, last, 0);
+    SET_LEN_PLIST(function_breakpoint_targets, last - 1);
+    SET_LEN_PLIST(function_breakpoint_callbacks, last - 1);
+    ConsiderEnableDisableDebugging();
+    return True;
+}
+
+static Obj FuncGET_FUNCTION_BREAKPOINTS(Obj self)
+{
+    return SHALLOW_COPY_OBJ(function_breakpoint_targets);
 }
 
 static Obj FuncCLEAR_ALL_BREAKPOINTS(Obj self)
 {
     breakpoint_functions = NEW_PLIST(T_PLIST, 0);
+    body_cache = NEW_PLIST(T_PLIST, BODY_CACHE_SIZE);
+    SET_LEN_PLIST(body_cache, BODY_CACHE_SIZE);
     break_points.clear();
+    breakpoint_conditions.clear();
+    breakpoint_index.clear();
+    function_breakpoint_targets = NEW_PLIST(T_PLIST, 0);
+    function_breakpoint_callbacks = NEW_PLIST(T_PLIST, 0);
+    function_breakpoint_index.clear();
+    pending_breakpoints.clear();
+    pending_breakpoint_functions = NEW_PLIST(T_PLIST, 0);
+    releaseUnusedHistories();
     ConsiderEnableDisableDebugging();
     return 0;
 }
@@ -268,45 +1294,107 @@ static Obj FuncGET_BREAKPOINTS(Obj self)
     return GAP_make(break_points);
 }
 
+static Obj FuncGET_BREAKPOINT_HITS(Obj self)
+{
+    Obj list = NEW_PLIST(T_PLIST, break_points.size());
+    for(UInt i = 0; i < break_points.size(); ++i)
+    {
+        Obj triple = NEW_PLIST(T_PLIST, 3);
+        SET_LEN_PLIST(triple, 3);
+        SET_ELM_PLIST(triple, 1, INTOBJ_INT(break_points[i].first));
+        SET_ELM_PLIST(triple, 2, INTOBJ_INT(break_points[i].second));
+        SET_ELM_PLIST(triple, 3, ObjInt_UInt(breakpoint_conditions[i].hits));
+        CHANGED_BAG(triple);
+        PushPlist(list, triple);
+    }
+    return list;
+}
+
+// The hits recorded by breakpoints at 'file:line' which have histories
+static Obj FuncGET_BREAKPOINT_HISTORY(Obj self, Obj file, Obj line)
+{
+    if(!IS_INTOBJ(file) || !IS_INTOBJ(line))
+    {
+        ErrorMayQuit("Usage: GET_BREAKPOINT_HISTORY(file, line)",0,0);
+    }
+    std::pair<Int, Int> location(INT_INTOBJ(file), INT_INTOBJ(line));
+    Obj list = NEW_PLIST(T_PLIST, 0);
+    for(UInt i = 0; i < break_points.size(); ++i)
+    {
+        if(break_points[i] != location || !breakpoint_conditions[i].history)
+            continue;
+        Obj hits = breakpointHistory(breakpoint_conditions[i].history);
+        for(Int j = 1; j <= LEN_PLIST(hits); ++j)
+            PushPlist(list, ELM_PLIST(hits, j));
+    }
+    return list;
+}
+
+// The hooks for each combination of HookFeatures
+static struct InterpreterHooks debug_hooks[HookAllFeatures + 1];
+
+template<int Features>
+static void initHooks()
+{
+    struct InterpreterHooks& hooks = debug_hooks[Features];
+    memset(&hooks, 0, sizeof(hooks));
+    hooks.hookName = "debugger";
+    if(Features & HookStatFeatures)
+        hooks.visitStat = debugVisitStat<Features & HookStatFeatures>;
+    if(Features & HookCallFeatures)
+    {
+        hooks.enterFunction = debugEnterFunction<Features & HookCallFeatures>;
+        hooks.leaveFunction = debugLeaveFunction<Features & HookCallFeatures>;
+    }
 #if GAP_KERNEL_MAJOR_VERSION >= 6
-struct InterpreterHooks debugHooks =
-{
-    debugVisitStat,
-    0,
-    debugEnterFunction,
-    debugLeaveFunction,
-    0,
-    0,
-    "debugger"
-};
-#else
-struct InterpreterHooks debugHooks =
-{
-    debugVisitStat,
-    debugEnterFunction,
-    debugLeaveFunction,
-    0,
-    "debugger"
-};
+    if(Features & HookStatRecord)
+    {
+        hooks.visitInterpretedStat = debugVisitInterpretedStat;
+        hooks.registerStat = debugRegisterStat;
+        hooks.registerInterpretedStat = debugRegisterInterpretedStat;
+    }
 #endif
+    initHooks<Features - 1>();
+}
+
+template<>
+void initHooks<-1>()
+{ }
+
+// The features of the hooks currently installed, or -1 if none are
+static int active_features = -1;
+
+// Install the hooks for 'features', or remove our hooks if it is -1
+static void installHooks(int features)
+{
+    if(features == active_features)
+        return;
+    // Only hooks with HookStatBreak update prevlocation, so it may be stale
+    if(!(active_features >= 0 && (active_features & HookStatBreak)))
+        prevlocation = std::pair<Int, Int>(0, 0);
+    if(active_features >= 0)
+        DeactivateHooks(&debug_hooks[active_features]);
+    active_features = features;
+    if(features >= 0)
+        ActivateHooks(&debug_hooks[features]);
+}
+
+static void installFeatureHooks(int features)
+{
+    installHooks(features ? features : -1);
+}
+
+// Install hooks with every feature, whichever features are active
 static Obj FuncACTIVATE_DEBUGGING(Obj self)
 {
-#if GAP_KERNEL_MAJOR_VERSION >= 8
-    ActivateHooks(&debugHooks);
+    installHooks(HookAllFeatures);
     return True;
-#else
-    return ActivateHooks(&debugHooks) ? True : False;
-#endif
 }
 
 static Obj FuncDEACTIVATE_DEBUGGING(Obj self)
 {
-#if GAP_KERNEL_MAJOR_VERSION >= 8
-    DeactivateHooks(&debugHooks);
+    installHooks(-1);
     return True;
-#else
-    return DeactivateHooks(&debugHooks) ? True : False;
-#endif
 }
 
 // Table of functions to export
@@ -314,14 +1402,30 @@ static StructGVarFunc GVarFuncs [] = {
     GVAR_FUNC(ACTIVATE_DEBUGGING, 0, ""),
     GVAR_FUNC(DEACTIVATE_DEBUGGING, 0, ""),
     GVAR_FUNC(GET_BREAKPOINTS, 0, ""),
-    GVAR_FUNC(ADD_BREAKPOINT, 3, "file, line, func"),
+    GVAR_FUNC(GET_BREAKPOINT_HITS, 0, ""),
+    GVAR_FUNC(GET_BREAKPOINT_HISTORY, 2, "file, line"),
+    GVAR_FUNC(ADD_BREAKPOINT, -1, "file, line, func[, options]"),
     GVAR_FUNC(SET_EVERY_STATEMENT_BREAKPOINT, -1, "func"),
     GVAR_FUNC(SET_NEXT_STATEMENT_BREAKPOINT, -1, "func"),
     GVAR_FUNC(SET_EVERY_ENTER_FUNCTION_BREAKPOINT, -1, "func"),
     GVAR_FUNC(SET_NEXT_ENTER_FUNCTION_BREAKPOINT, -1, "func"),
     GVAR_FUNC(SET_EVERY_LEAVE_FUNCTION_BREAKPOINT, -1, "func"),
     GVAR_FUNC(SET_NEXT_LEAVE_FUNCTION_BREAKPOINT, -1, "func"),
+    GVAR_FUNC(STEP_OVER, -1, "[func]"),
+    GVAR_FUNC(STEP_OUT, -1, "[func]"),
+    GVAR_FUNC(STEP_LINES, -1, "n[, func]"),
     GVAR_FUNC(CLEAR_BREAKPOINT, 2, "file, line"),
+    GVAR_FUNC(ADD_BREAKPOINTS, 1, "list"),
+    GVAR_FUNC(CLEAR_BREAKPOINTS, 1, "list"),
+    GVAR_FUNC(SAVE_BREAKPOINTS, 1, "filename"),
+    GVAR_FUNC(READ_BREAKPOINT_FILE, 1, "filename"),
+    GVAR_FUNC(FIND_FILE_IDS, 1, "fileend"),
+    GVAR_FUNC(ADD_PENDING_BREAKPOINT, -1, "fileend, line, func[, options]"),
+    GVAR_FUNC(CLEAR_PENDING_BREAKPOINT, 2, "fileend, line"),
+    GVAR_FUNC(GET_PENDING_BREAKPOINTS, 0, ""),
+    GVAR_FUNC(ADD_FUNCTION_BREAKPOINT, 2, "func, callback"),
+    GVAR_FUNC(CLEAR_FUNCTION_BREAKPOINT, 1, "func"),
+    GVAR_FUNC(GET_FUNCTION_BREAKPOINTS, 0, ""),
 	GVAR_FUNC(CLEAR_ALL_BREAKPOINTS, 0, ""),
     { 0 } /* Finish with an empty entry */
 
@@ -334,13 +1438,37 @@ static Int InitKernel( StructInitInfo *module )
 {
     /* init filters and functions                                          */
     InitHdlrFuncsFromTable( GVarFuncs );
+    initHooks<HookAllFeatures>();
+    InitKernelLineProfile();
+    InitKernelFunctionProfile();
+    InitKernelAllocationProfile();
+    InitKernelSampleProfile();
+    InitKernelEventTrace();
+    InitKernelTraceFile();
+    InitKernelCheckpoint();
+    InitKernelLogpoint();
+    InitKernelChromeTrace();
+    InitKernelWatch();
+    InitKernelHeapGrowth();
+    InitKernelCoverage();
+    InitKernelSharedProfile();
+    InitKernelShadowStack();
+    InitKernelInspect();
+    InitKernelHistory();
 
     InitGlobalBag(&breakpoint_functions, "src/debugger.cc:breakpoint_functions");
+    InitGlobalBag(&body_cache, "src/debugger.cc:body_cache");
+    InitGlobalBag(&pending_breakpoint_functions, "src/debugger.cc:pending_breakpoint_functions");
+    InitGlobalBag(&function_breakpoint_targets, "src/debugger.cc:function_breakpoint_targets");
+    InitGlobalBag(&function_breakpoint_callbacks, "src/debugger.cc:function_breakpoint_callbacks");
     InitGlobalBag(&next_step_function, "src/debugger.cc:next_step_function");
     InitGlobalBag(&every_step_function, "src/debugger.cc:every_step_function");
     InitGlobalBag(&next_enter_function, "src/debugger.cc:next_enter_function");
     InitGlobalBag(&every_enter_function, "src/debugger.cc:every_enter_function");
     InitGlobalBag(&next_leave_function, "src/debugger.cc:next_leave_function");
+    InitGlobalBag(&step_function, "src/debugger.cc:step_function");
+    InitGlobalBag(&step_frame, "src/debugger.cc:step_frame");
+    InitGlobalBag(&stopped_frame, "src/debugger.cc:stopped_frame");
     InitGlobalBag(&every_leave_function, "src/debugger.cc:every_leave_function");
 
     /* return success                                                      */
@@ -354,9 +1482,31 @@ static Int InitLibrary( StructInitInfo *module )
 {
     /* init filters and functions */
     InitGVarFuncsFromTable( GVarFuncs );
+    InitLibraryLineProfile();
+    InitLibraryFunctionProfile();
+    InitLibraryAllocationProfile();
+    InitLibrarySampleProfile();
+    InitLibraryEventTrace();
+    InitLibraryTraceFile();
+    InitLibraryCheckpoint();
+    InitLibraryLogpoint();
+    InitLibraryChromeTrace();
+    InitLibraryWatch();
+    InitLibraryHeapGrowth();
+    InitLibraryCoverage();
+    InitLibrarySharedProfile();
+    InitLibraryShadowStack();
+    InitLibraryInspect();
+    InitLibraryHistory();
 
     breakpoint_functions = NEW_PLIST(T_PLIST, 0);
+    pending_breakpoint_functions = NEW_PLIST(T_PLIST, 0);
+    function_breakpoint_targets = NEW_PLIST(T_PLIST, 0);
+    function_breakpoint_callbacks = NEW_PLIST(T_PLIST, 0);
+    body_cache = NEW_PLIST(T_PLIST, BODY_CACHE_SIZE);
+    SET_LEN_PLIST(body_cache, BODY_CACHE_SIZE);
 
+    findFilenameCache();
     RegisterThrowObserver(resetDebuggerOnThrow);
     RegisterBreakloopObserver(resetDebuggerOnBreakLoop);
 
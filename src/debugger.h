@@ -0,0 +1,165 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * Declarations shared between the parts of the debugger kernel extension.
+ */
+
+#ifndef DEBUGGER_H_PQXMTA
+#define DEBUGGER_H_PQXMTA
+
+extern "C" {
+#include "gap_all.h"   // GAP headers
+}
+
+#include <signal.h>
+
+#include <string>
+#include <vector>
+
+// Checks if we are currently inside a function called by the debugger,
+// or inside the break loop, so we should not invoke any more debugging
+// functions, to avoid infinite loops.
+extern Int disable_debugger;
+
+// Check if we should enable or disable hooks
+void ConsiderEnableDisableDebugging();
+
+
+// Line profiler (lineprofile.cc)
+extern bool line_profile_active;
+void lineProfileVisitStat(Int file, Int line);
+Int InitKernelLineProfile();
+Int InitLibraryLineProfile();
+
+// Function profiler (funcprofile.cc)
+extern bool func_profile_active;
+void funcProfileEnter(Obj func);
+void funcProfileLeave(Obj func);
+void funcProfileReset();
+Int InitKernelFunctionProfile();
+Int InitLibraryFunctionProfile();
+
+// Allocation profiler (allocprofile.cc)
+extern bool alloc_profile_active;
+void allocProfileVisitStat(Int file, Int line);
+void allocProfileEnter(Obj func);
+void allocProfileLeave(Obj func);
+void allocProfileReset();
+Int InitKernelAllocationProfile();
+Int InitLibraryAllocationProfile();
+
+// Profile counters shared between processes (sharedprofile.cc)
+extern bool shared_profile_active;
+void sharedProfileVisitStat(Int file, Int line);
+void sharedProfileEnter(Obj func);
+Int InitKernelSharedProfile();
+Int InitLibrarySharedProfile();
+
+// Shadow call stack (shadowstack.cc)
+extern bool shadow_stack_active;
+void shadowStackVisitStat(Int file, Int line);
+void shadowStackEnter(Obj func);
+void shadowStackLeave(Obj func);
+// Called when GAP jumps out of functions
+void shadowStackReset();
+// Remember the stack when a breakpoint fires
+void shadowStackCapture();
+// The functions on the stack, innermost first
+Obj shadowStackFunctions();
+Int InitKernelShadowStack();
+Int InitLibraryShadowStack();
+
+// Histories of local variables recorded at breakpoints (history.cc)
+// Returns the id of a new history for a breakpoint with these options,
+// or 0 if they do not ask for one
+Int newBreakpointHistory(Obj options);
+// Checks the history options without creating a history, and returns
+// the number of slots it would use
+UInt breakpointHistorySlots(Obj options);
+// Raises an error if 'slots' more slots would use too much memory
+void checkBreakpointHistorySlots(UInt slots);
+void breakpointHistoryRecord(Int id, UInt hit);
+// The options of a history, as written in saved breakpoint files
+std::string savedBreakpointHistory(Int id);
+// Add the options saved by savedBreakpointHistory to 'options'. Returns
+// false if 'text' is not valid.
+bool readSavedBreakpointHistory(const std::string& text, Obj options);
+Obj breakpointHistory(Int id);
+// Free every history whose id is not in 'ids'
+void keepBreakpointHistories(const std::vector<Int>& ids);
+Int InitKernelHistory();
+Int InitLibraryHistory();
+
+// Describing local variables (inspect.cc)
+Int InitKernelInspect();
+Int InitLibraryInspect();
+
+// Line coverage (coverage.cc)
+extern bool coverage_active;
+void coverageVisitStat(Int file, Int line);
+void coverageRegisterStat(Int file, Int line);
+Int InitKernelCoverage();
+Int InitLibraryCoverage();
+
+// Sampling profiler (sampling.cc)
+// Set from a signal handler when the next hook should take a sample
+extern volatile sig_atomic_t sample_pending;
+extern bool sample_profile_active;
+void samplingTakeSample(Int line);
+Int InitKernelSampleProfile();
+Int InitLibrarySampleProfile();
+
+// Event trace (eventtrace.cc)
+// The kinds of event, as given to GAP
+enum EventKind { EventStatement = 1, EventEnter = 2, EventLeave = 3 };
+extern bool event_trace_active;
+void eventTraceVisitStat(Obj body, Int file, Int line);
+void eventTraceEnter(Obj func);
+void eventTraceLeave(Obj func);
+Int InitKernelEventTrace();
+Int InitLibraryEventTrace();
+
+// Binary trace file (tracefile.cc)
+extern bool trace_file_active;
+void traceFileVisitStat(Int file, Int line);
+void traceFileEnter(Obj func);
+void traceFileLeave(Obj func);
+Int InitKernelTraceFile();
+Int InitLibraryTraceFile();
+
+// Checkpoint traces, to compare two runs (checkpoint.cc)
+extern bool checkpoint_active;
+void checkpointVisitStat(Int file, Int line);
+Int InitKernelCheckpoint();
+Int InitLibraryCheckpoint();
+
+// Chrome trace event export (chrometrace.cc)
+extern bool chrome_trace_active;
+void chromeTraceEnter(Obj func);
+void chromeTraceLeave(Obj func);
+// Called when GAP jumps out of functions
+void chromeTraceReset();
+Int InitKernelChromeTrace();
+Int InitLibraryChromeTrace();
+
+// Logpoints, which log messages without stopping (logpoint.cc)
+extern bool logpoint_active;
+void logpointVisitStat(Int file, Int line);
+void logpointEnterFunction();
+Int InitKernelLogpoint();
+Int InitLibraryLogpoint();
+
+// Watchpoints on global variables (watch.cc)
+extern bool watch_active;
+void watchVisitStat(Int file, Int line);
+void watchLeaveFunction();
+Int InitKernelWatch();
+Int InitLibraryWatch();
+
+// Heap growth tripwire (heapgrowth.cc)
+extern bool heap_growth_active;
+void heapGrowthCheck(Int file, Int line);
+Int InitKernelHeapGrowth();
+Int InitLibraryHeapGrowth();
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * An in-memory trace of statements, function entries and function exits.
+ * The hooks append small fixed-size records to a ring buffer, which GAP
+ * code can drain in bulk, rather than calling a GAP function per event.
+ */
+
+#include "debugger.h"
+#include "function_table.hpp"
+#include "timer.hpp"
+
+#include <vector>
+
+bool event_trace_active;
+
+#define DEFAULT_TRACE_SIZE (1 << 20)
+#define DEFAULT_DRAIN_SIZE (1 << 16)
+
+struct TraceEvent
+{
+    UInt4 kind;
+    UInt4 file;
+    UInt4 line;
+    UInt4 function;
+    uint64_t ticks;
+};
+
+static FunctionTable traced_functions;
+
+// The ring buffer. 'event_start' is the oldest event, and there are
+// 'event_count' events. When the buffer is full, the oldest event is
+// overwritten, and counted in 'events_lost'.
+static std::vector<TraceEvent> events;
+static UInt event_start;
+static UInt event_count;
+static UInt events_lost;
+
+static TickCalibration event_calibration;
+
+// The last statement recorded, so we only record changes of line
+static Int event_prev_file;
+static Int event_prev_line;
+
+// The last body seen in a statement event, and its index. The body is
+// kept alive by traced_functions, so cannot be replaced by another body
+// at the same address.
+static Obj event_prev_body;
+static Int event_prev_function;
+
+static void pushEvent(UInt4 kind, Int file, Int line, Int function)
+{
+    UInt pos = event_start + event_count;
+    if(pos >= events.size())
+        pos -= events.size();
+    TraceEvent& e = events[pos];
+    e.kind = kind;
+    e.file = file;
+    e.line = line;
+    e.function = function;
+    e.ticks = readTicks();
+    if(event_count < events.size())
+        event_count++;
+    else
+    {
+        event_start++;
+        if(event_start == events.size())
+            event_start = 0;
+        events_lost++;
+    }
+}
+
+void eventTraceVisitStat(Obj body, Int file, Int line)
+{
+    if(file == event_prev_file && line == event_prev_line)
+        return;
+    event_prev_file = file;
+    event_prev_line = line;
+    if(body != event_prev_body)
+    {
+        event_prev_function = traced_functions.lookup(CURR_FUNC());
+        event_prev_body = body;
+    }
+    pushEvent(EventStatement, file, line, event_prev_function);
+}
+
+static void pushFunctionEvent(UInt4 kind, Obj func)
+{
+    Obj body = BODY_FUNC(func);
+    pushEvent(kind, GET_GAPNAMEID_BODY(body), GET_STARTLINE_BODY(body),
+              traced_functions.lookup(func));
+    event_prev_file = 0;
+}
+
+void eventTraceEnter(Obj func)
+{ pushFunctionEvent(EventEnter, func); }
+
+void eventTraceLeave(Obj func)
+{ pushFunctionEvent(EventLeave, func); }
+
+// We do the argument handling for these functions in C, so no GAP
+// function is run (and traced) after the trace starts.
+static Obj FuncSTART_EVENT_TRACE(Obj self, Obj args)
+{
+    Obj size = INTOBJ_INT(DEFAULT_TRACE_SIZE);
+    if(LEN_PLIST(args) == 1)
+        size = ELM_PLIST(args, 1);
+    if(LEN_PLIST(args) > 1 || !IS_POS_INTOBJ(size))
+    {
+        ErrorMayQuit("Usage: StartEventTrace([size]), where size is a "
+                     "positive integer",0,0);
+    }
+    if((UInt)INT_INTOBJ(size) != events.size())
+    {
+        std::vector<TraceEvent> newevents(INT_INTOBJ(size));
+        events.swap(newevents);
+        event_start = 0;
+        event_count = 0;
+    }
+    if(event_count == 0)
+        event_calibration.reset();
+    event_prev_file = 0;
+    event_trace_active = true;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncSTOP_EVENT_TRACE(Obj self)
+{
+    event_trace_active = false;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+// Remove (at most) 'max' events from the buffer, returning them as a list
+// of [kind, file, line, function, time] lists.
+static Obj FuncDRAIN_EVENT_TRACE(Obj self, Obj args)
+{
+    Obj max = INTOBJ_INT(DEFAULT_DRAIN_SIZE);
+    if(LEN_PLIST(args) == 1)
+        max = ELM_PLIST(args, 1);
+    if(LEN_PLIST(args) > 1 || !IS_NONNEG_INTOBJ(max))
+    {
+        ErrorMayQuit("Usage: DrainEventTrace([max]), where max is a "
+                     "non-negative integer",0,0);
+    }
+    UInt n = INT_INTOBJ(max);
+    if(n > event_count)
+        n = event_count;
+    double scale = event_calibration.nanosPerTick();
+    Obj list = NEW_PLIST(T_PLIST, n);
+    for(UInt i = 0; i < n; ++i)
+    {
+        const TraceEvent& e = events[event_start];
+        Obj entry = NEW_PLIST(T_PLIST, 5);
+        SET_LEN_PLIST(entry, 5);
+        SET_ELM_PLIST(entry, 1, INTOBJ_INT(e.kind));
+        SET_ELM_PLIST(entry, 2, INTOBJ_INT(e.file));
+        SET_ELM_PLIST(entry, 3, INTOBJ_INT(e.line));
+        SET_ELM_PLIST(entry, 4, INTOBJ_INT(e.function + 1));
+        SET_ELM_PLIST(entry, 5, ObjInt_UInt8((UInt8)(e.ticks * scale)));
+        SET_ELM_PLIST(list, i + 1, entry);
+        SET_LEN_PLIST(list, i + 1);
+        CHANGED_BAG(list);
+        event_start++;
+        if(event_start == events.size())
+            event_start = 0;
+        event_count--;
+    }
+    return list;
+}
+
+static Obj FuncEVENT_TRACE_FUNCTIONS(Obj self)
+{
+    return SHALLOW_COPY_OBJ(traced_functions.functions);
+}
+
+static Obj FuncEVENT_TRACE_LOST(Obj self)
+{
+    return ObjInt_UInt(events_lost);
+}
+
+static Obj FuncCLEAR_EVENT_TRACE(Obj self)
+{
+    event_start = 0;
+    event_count = 0;
+    events_lost = 0;
+    event_prev_file = 0;
+    event_prev_body = 0;
+    traced_functions.clear();
+    event_calibration.reset();
+    return 0;
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(START_EVENT_TRACE, -1, "[size]"),
+    GVAR_FUNC(STOP_EVENT_TRACE, 0, ""),
+    GVAR_FUNC(DRAIN_EVENT_TRACE, -1, "[max]"),
+    GVAR_FUNC(EVENT_TRACE_FUNCTIONS, 0, ""),
+    GVAR_FUNC(EVENT_TRACE_LOST, 0, ""),
+    GVAR_FUNC(CLEAR_EVENT_TRACE, 0, ""),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelEventTrace()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    InitGlobalBag(&traced_functions.functions, "src/eventtrace.cc:traced_functions");
+    return 0;
+}
+
+Int InitLibraryEventTrace()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    traced_functions.init();
+    return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef FILENAME_INDEX_HPP_RVSTFX
+#define FILENAME_INDEX_HPP_RVSTFX
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gap_all.h"   // GAP headers
+
+// An index of the filenames GAP has read, for finding all files whose
+// name ends with a given string without comparing against every file.
+//
+// Names are stored reversed and sorted, so all names with a given suffix
+// form a range starting at the reversed suffix. New names are appended,
+// and the list is only sorted again when it is next searched.
+class FilenameIndex
+{
+    std::vector<std::pair<std::string, Int> > reversed;
+    // The number of file ids added, which are always 1, 2, 3, ...
+    Int known;
+    bool sorted;
+
+    static std::string reverse(const char* s)
+    {
+        std::string r(s);
+        std::reverse(r.begin(), r.end());
+        return r;
+    }
+
+public:
+    FilenameIndex() : known(0), sorted(true)
+    { }
+
+    // The largest file id added
+    Int knownFiles() const
+    { return known; }
+
+    // Add the name of the next file id
+    void add(const char* name)
+    {
+        known++;
+        reversed.push_back(std::make_pair(reverse(name), known));
+        sorted = false;
+    }
+
+    static bool endsWith(const char* name, const std::string& suffix)
+    {
+        size_t len = strlen(name);
+        return len >= suffix.size() &&
+               suffix.compare(0, suffix.size(), name + len - suffix.size()) == 0;
+    }
+
+    // Returns the ids of all files whose name ends with 'suffix', in
+    // increasing order
+    std::vector<Int> find(const char* suffix)
+    {
+        if(!sorted)
+        {
+            std::sort(reversed.begin(), reversed.end());
+            sorted = true;
+        }
+        std::string key = reverse(suffix);
+        std::vector<Int> ids;
+        std::vector<std::pair<std::string, Int> >::const_iterator it =
+            std::lower_bound(reversed.begin(), reversed.end(),
+                             std::make_pair(key, (Int)0));
+        for(; it != reversed.end() && it->first.compare(0, key.size(), key) == 0; ++it)
+            ids.push_back(it->second);
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+};
+
+#endif
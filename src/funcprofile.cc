@@ -0,0 +1,175 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * A native function profiler, which records the distribution of the time
+ * spent in each function, so we can report tail latencies and not just
+ * averages.
+ */
+
+#include "debugger.h"
+#include "function_table.hpp"
+#include "histogram.hpp"
+#include "timer.hpp"
+
+#include <vector>
+
+bool func_profile_active;
+
+static FunctionTable profiled_functions;
+
+struct FunctionTimes
+{
+    // Time from entering to leaving the function, including called
+    // functions. For recursive functions, only the outermost call is
+    // recorded, so time is not counted twice.
+    LogHistogram inclusive;
+    // Time spent in the function itself, excluding called functions
+    LogHistogram self;
+    // Number of calls of this function currently running
+    Int active;
+
+    FunctionTimes() : active(0)
+    { }
+};
+
+// Indexed by the position of the function in profiled_functions
+static std::vector<FunctionTimes> function_times;
+
+struct ProfileFrame
+{
+    Int function;
+    uint64_t start;
+    // Time spent in functions called from this frame
+    uint64_t children;
+};
+
+static std::vector<ProfileFrame> profile_stack;
+
+static TickCalibration func_calibration;
+
+void funcProfileEnter(Obj func)
+{
+    Int pos = profiled_functions.lookup(func);
+    if((UInt)pos >= function_times.size())
+        function_times.resize(pos + 1);
+    function_times[pos].active++;
+    ProfileFrame frame = { pos, readTicks(), 0 };
+    profile_stack.push_back(frame);
+}
+
+void funcProfileLeave(Obj func)
+{
+    uint64_t now = readTicks();
+    Int pos = profiled_functions.lookup(func);
+    // If the stack does not match (because we started profiling part way
+    // through a function, or GAP jumped out of some functions), then drop
+    // frames until it does.
+    UInt depth = profile_stack.size();
+    while(depth > 0 && profile_stack[depth - 1].function != pos)
+        depth--;
+    if(depth == 0)
+        return;
+    while(profile_stack.size() > depth)
+    {
+        function_times[profile_stack.back().function].active--;
+        profile_stack.pop_back();
+    }
+
+    ProfileFrame frame = profile_stack.back();
+    profile_stack.pop_back();
+    uint64_t elapsed = now - frame.start;
+    FunctionTimes& times = function_times[pos];
+    times.self.record(elapsed - frame.children);
+    times.active--;
+    if(times.active == 0)
+        times.inclusive.record(elapsed);
+    if(!profile_stack.empty())
+        profile_stack.back().children += elapsed;
+}
+
+void funcProfileReset()
+{
+    for(UInt i = 0; i < profile_stack.size(); ++i)
+        function_times[profile_stack[i].function].active--;
+    profile_stack.clear();
+}
+
+static Obj FuncSTART_FUNCTION_PROFILE(Obj self)
+{
+    if(function_times.empty())
+        func_calibration.reset();
+    func_profile_active = true;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncSTOP_FUNCTION_PROFILE(Obj self)
+{
+    func_profile_active = false;
+    funcProfileReset();
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncCLEAR_FUNCTION_PROFILE(Obj self)
+{
+    profile_stack.clear();
+    function_times.clear();
+    profiled_functions.clear();
+    func_calibration.reset();
+    return 0;
+}
+
+static Obj HistogramToRecord(const LogHistogram& hist, double scale)
+{
+    Obj rec = NEW_PREC(5);
+    AssPRec(rec, RNamName("count"), ObjInt_UInt8(hist.count()));
+    AssPRec(rec, RNamName("total"), ObjInt_UInt8((UInt8)(hist.total() * scale)));
+    AssPRec(rec, RNamName("p50"), ObjInt_UInt8((UInt8)(hist.quantile(0.5) * scale)));
+    AssPRec(rec, RNamName("p99"), ObjInt_UInt8((UInt8)(hist.quantile(0.99) * scale)));
+    AssPRec(rec, RNamName("max"), ObjInt_UInt8((UInt8)(hist.max() * scale)));
+    return rec;
+}
+
+static Obj FuncGET_FUNCTION_PROFILE(Obj self)
+{
+    double scale = func_calibration.nanosPerTick();
+    Obj list = NEW_PLIST(T_PLIST, 0);
+    for(UInt i = 0; i < function_times.size(); ++i)
+    {
+        const FunctionTimes& times = function_times[i];
+        if(times.self.count() == 0)
+            continue;
+        Obj func = profiled_functions.function(i);
+        Obj rec = NEW_PREC(4);
+        AssPRec(rec, RNamName("func"), func);
+        AssPRec(rec, RNamName("calls"), ObjInt_UInt8(times.self.count()));
+        AssPRec(rec, RNamName("inclusive"), HistogramToRecord(times.inclusive, scale));
+        AssPRec(rec, RNamName("self"), HistogramToRecord(times.self, scale));
+        PushPlist(list, rec);
+    }
+    return list;
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(START_FUNCTION_PROFILE, 0, ""),
+    GVAR_FUNC(STOP_FUNCTION_PROFILE, 0, ""),
+    GVAR_FUNC(CLEAR_FUNCTION_PROFILE, 0, ""),
+    GVAR_FUNC(GET_FUNCTION_PROFILE, 0, ""),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelFunctionProfile()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    InitGlobalBag(&profiled_functions.functions, "src/funcprofile.cc:profiled_functions");
+    return 0;
+}
+
+Int InitLibraryFunctionProfile()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    profiled_functions.init();
+    return 0;
+}
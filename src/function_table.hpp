@@ -0,0 +1,53 @@
+#ifndef FUNCTION_TABLE_HPP_WLXRTB
+#define FUNCTION_TABLE_HPP_WLXRTB
+
+#include <unordered_map>
+
+#include "gap_all.h"   // GAP headers
+
+// Gives each function body a small integer (starting at 0), so native
+// tables can be indexed by function. Closures made from the same
+// expression share a body, so are treated as one function.
+//
+// The first function seen with each body is stored in the GAP list
+// 'functions', which keeps it (and its body) from being garbage collected.
+// The owner must register 'functions' with InitGlobalBag, and call 'init'
+// from InitLibrary.
+class FunctionTable
+{
+    std::unordered_map<Obj, Int> index;
+public:
+    Obj functions;
+
+    FunctionTable() : functions(0)
+    { }
+
+    void init()
+    { functions = NEW_PLIST(T_PLIST, 0); }
+
+    Int lookup(Obj func)
+    {
+        Obj body = BODY_FUNC(func);
+        std::unordered_map<Obj, Int>::const_iterator it = index.find(body);
+        if(it != index.end())
+            return it->second;
+        Int pos = PushPlist(functions, func) - 1;
+        index[body] = pos;
+        return pos;
+    }
+
+    Int size() const
+    { return LEN_PLIST(functions); }
+
+    // Returns the function with index 'i'
+    Obj function(Int i) const
+    { return ELM_PLIST(functions, i + 1); }
+
+    void clear()
+    {
+        index.clear();
+        init();
+    }
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * A tripwire which calls a GAP function once the GAP heap has grown by
+ * more than a given number of bytes since the tripwire was set. The size
+ * of the heap is read from GASMAN's counters rather than the size of the
+ * process, as GASMAN keeps memory it has freed, and the process also
+ * holds memory which is not in the heap. Reading the counters is cheap,
+ * so we check on every statement.
+ */
+
+#include "debugger.h"
+
+bool heap_growth_active;
+
+static Obj heap_growth_callback;
+
+// The size when the tripwire was set, and how much it may grow by
+static uint64_t heap_start;
+static uint64_t heap_limit;
+
+#ifdef USE_GASMAN
+// SizeAllBags when the last garbage collection finished
+static UInt8 heap_allocated_at_gc;
+
+static void heapGrowthAfterCollect()
+{
+    heap_allocated_at_gc = SizeAllBags;
+}
+#endif
+
+// The bytes of the bags which survived the last garbage collection, plus
+// those allocated since. Bags which have died since are counted until the
+// next collection.
+static uint64_t heapBytes()
+{
+#ifdef USE_GASMAN
+    return (uint64_t)SizeLiveBags + (SizeAllBags - heap_allocated_at_gc);
+#else
+    return 0;
+#endif
+}
+
+// The functions currently running, innermost first, from the shadow
+// stack if it is running
+static Obj currentStack()
+{
+    if(shadow_stack_active)
+        return shadowStackFunctions();
+    Obj stack = NEW_PLIST(T_PLIST, 0);
+    Obj lvars = STATE(CurrLVars);
+    while(!IsBottomLVars(lvars))
+    {
+        PushPlist(stack, FUNC_LVARS(lvars));
+        lvars = PARENT_LVARS(lvars);
+    }
+    return stack;
+}
+
+void heapGrowthCheck(Int file, Int line)
+{
+    uint64_t size = heapBytes();
+    if(size <= heap_start || size - heap_start <= heap_limit)
+        return;
+    Obj callback = heap_growth_callback;
+    heap_growth_callback = 0;
+    heap_growth_active = false;
+    ConsiderEnableDisableDebugging();
+    disable_debugger = 1;
+    CALL_4ARGS(callback, INTOBJ_INT(file), INTOBJ_INT(line),
+               ObjInt_UInt8(size - heap_start), currentStack());
+    disable_debugger = 0;
+}
+
+static Obj FuncSET_HEAP_GROWTH_BREAKPOINT(Obj self, Obj bytes, Obj callback)
+{
+    if(callback == Fail)
+    {
+        heap_growth_callback = 0;
+        heap_growth_active = false;
+        ConsiderEnableDisableDebugging();
+        return 0;
+    }
+    if(!IS_POS_INTOBJ(bytes) || !IS_FUNC(callback))
+    {
+        ErrorMayQuit("Usage: BreakOnHeapGrowth(bytes[, callback])",0,0);
+    }
+#ifndef USE_GASMAN
+    ErrorMayQuit("BreakOnHeapGrowth: requires GAP to use GASMAN",0,0);
+#endif
+    heap_growth_callback = callback;
+    heap_start = heapBytes();
+    heap_limit = INT_INTOBJ(bytes);
+    heap_growth_active = true;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncHEAP_SIZE(Obj self)
+{
+#ifndef USE_GASMAN
+    ErrorMayQuit("HEAP_SIZE: requires GAP to use GASMAN",0,0);
+#endif
+    return ObjInt_UInt8(heapBytes());
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(SET_HEAP_GROWTH_BREAKPOINT, 2, "bytes, callback"),
+    GVAR_FUNC(HEAP_SIZE, 0, ""),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelHeapGrowth()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    InitGlobalBag(&heap_growth_callback, "src/heapgrowth.cc:heap_growth_callback");
+#ifdef USE_GASMAN
+    RegisterAfterCollectFuncBags(heapGrowthAfterCollect);
+#endif
+    return 0;
+}
+
+Int InitLibraryHeapGrowth()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef HISTOGRAM_HPP_MVXQJD
+#define HISTOGRAM_HPP_MVXQJD
+
+#include <vector>
+#include <stdint.h>
+
+// A histogram with logarithmically sized buckets, in the style of
+// HdrHistogram. Each power of two is split into SUB_BUCKETS linear buckets,
+// so values are recorded with a relative error of at most 1/SUB_BUCKETS,
+// in constant space, however large they get.
+class LogHistogram
+{
+    static const int SUB_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    // Values are clamped below 2^MAX_BITS
+    static const int MAX_BITS = 52;
+    static const int BUCKETS = SUB_BUCKETS * (MAX_BITS - SUB_BITS + 1);
+
+    std::vector<uint64_t> counts;
+    uint64_t total_count;
+    uint64_t max_value;
+    uint64_t sum;
+
+    static int bucketOf(uint64_t v)
+    {
+        if(v < (uint64_t)SUB_BUCKETS)
+            return v;
+        int bits = 63 - __builtin_clzll(v);
+        if(bits >= MAX_BITS)
+            return BUCKETS - 1;
+        int sub = (v >> (bits - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return SUB_BUCKETS * (bits - SUB_BITS + 1) + sub;
+    }
+
+    // The largest value which is stored in bucket 'b'
+    static uint64_t bucketHigh(int b)
+    {
+        if(b < SUB_BUCKETS)
+            return b;
+        int bits = b / SUB_BUCKETS + SUB_BITS - 1;
+        uint64_t sub = b % SUB_BUCKETS;
+        uint64_t width = (uint64_t)1 << (bits - SUB_BITS);
+        return ((uint64_t)1 << bits) + (sub + 1) * width - 1;
+    }
+
+public:
+    LogHistogram() : total_count(0), max_value(0), sum(0)
+    { }
+
+    void record(uint64_t v)
+    {
+        if(counts.empty())
+            counts.resize(BUCKETS, 0);
+        counts[bucketOf(v)]++;
+        total_count++;
+        sum += v;
+        if(v > max_value)
+            max_value = v;
+    }
+
+    uint64_t count() const
+    { return total_count; }
+
+    uint64_t max() const
+    { return max_value; }
+
+    uint64_t total() const
+    { return sum; }
+
+    // Returns an upper bound for the value at quantile 'q' (between 0 and 1),
+    // which is never larger than the largest recorded value.
+    uint64_t quantile(double q) const
+    {
+        if(total_count == 0)
+            return 0;
+        uint64_t target = (uint64_t)(q * total_count + 0.5);
+        if(target == 0)
+            target = 1;
+        uint64_t seen = 0;
+        for(int b = 0; b < BUCKETS; ++b)
+        {
+            seen += counts[b];
+            if(seen >= target)
+            {
+                if(b == BUCKETS - 1 || bucketHigh(b) > max_value)
+                    return max_value;
+                return bucketHigh(b);
+            }
+        }
+        return max_value;
+    }
+};
+
+#endif
@@ -0,0 +1,355 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * Histories of local variables recorded at breakpoints. A breakpoint
+ * with a history does not stop: each time it fires, the values of some
+ * variables are stored in a ring of fixed size, replacing the oldest
+ * entry once the ring is full, and can be read afterwards.
+ *
+ * Rings are GAP lists, so the GC sees the values in them. The entry for
+ * each slot of a ring is created when the slot is first used, and then
+ * reused, so recording a hit does not allocate unless values are copied.
+ *
+ * The values held by all histories together, whether copied or not, are
+ * limited to HISTORY_MAX_BYTES. Values which would go over this are
+ * summarised instead.
+ */
+
+#include "debugger.h"
+#include "variables.hpp"
+
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+// The most entries all histories together can hold
+#define HISTORY_MAX_SLOTS (1 << 20)
+// The most bytes of values all histories together can hold
+#define HISTORY_MAX_BYTES (64 << 20)
+
+// The largest 'history' option, which is all the slots for one variable
+#define HISTORY_MAX_SIZE (HISTORY_MAX_SLOTS / 2)
+
+#define HISTORY_DEFAULT_SIZE 100
+#define HISTORY_DEFAULT_COPY_LIMIT 65536
+
+enum HistoryCopy { CopyReference, CopyShallow, CopySummary };
+
+struct BreakpointHistory
+{
+    std::vector<VariableRef> vars;
+    UInt size;
+    HistoryCopy copy;
+    // Mutable values larger than this are summarised rather than copied
+    UInt copy_limit;
+    // The number of hits recorded, including those since overwritten
+    UInt recorded;
+    // The bytes of values held in each slot, and in all of them
+    std::vector<UInt> slot_bytes;
+    UInt bytes;
+    bool in_use;
+};
+
+static std::vector<BreakpointHistory> histories;
+static UInt history_slots;
+static UInt history_bytes;
+
+// The ring of each history, in the same order as 'histories'. Each entry
+// of a ring is [hit, value1, value2, ...].
+static Obj history_rings;
+
+static UInt historyOption(Obj options, const char* name, UInt def, UInt max)
+{
+    UInt rnam = RNamName(name);
+    if(!ISB_REC(options, rnam))
+        return def;
+    Obj val = ELM_REC(options, rnam);
+    if(!IS_POS_INTOBJ(val))
+    {
+        ErrorMayQuit("Breakpoint option '%s' must be a positive integer",
+                     (Int)name, 0);
+    }
+    if((UInt)INT_INTOBJ(val) > max)
+    {
+        ErrorMayQuit("Breakpoint option '%s' must be at most %d",
+                     (Int)name, max);
+    }
+    return INT_INTOBJ(val);
+}
+
+// Read and check the history options into 'h'. Returns false if they
+// do not ask for a history.
+static bool readHistoryOptions(Obj options, BreakpointHistory& h)
+{
+    UInt rcapture = RNamName("capture");
+    if(!ISB_REC(options, rcapture))
+        return false;
+    Obj names = ELM_REC(options, rcapture);
+    if(!IS_SMALL_LIST(names) || LEN_LIST(names) == 0)
+    {
+        ErrorMayQuit("Breakpoint option 'capture' must be a list of variable names",0,0);
+    }
+    for(Int i = 1; i <= LEN_LIST(names); ++i)
+    {
+        Obj name = ELM0_LIST(names, i);
+        if(!name || !IS_STRING_REP(name))
+        {
+            ErrorMayQuit("Breakpoint option 'capture' must be a list of variable names",0,0);
+        }
+        h.vars.push_back(VariableRef(CONST_CSTR_STRING(name)));
+    }
+    h.size = historyOption(options, "history", HISTORY_DEFAULT_SIZE,
+                           HISTORY_MAX_SIZE);
+    h.copy_limit = historyOption(options, "copyLimit",
+                                 HISTORY_DEFAULT_COPY_LIMIT, HISTORY_MAX_BYTES);
+    // Checked this way round, as h.size * (h.vars.size() + 1) may overflow
+    if(h.vars.size() + 1 > HISTORY_MAX_SLOTS / h.size)
+    {
+        ErrorMayQuit("Breakpoint histories would use too much memory",0,0);
+    }
+    h.copy = CopyShallow;
+    UInt rcopy = RNamName("copy");
+    if(ISB_REC(options, rcopy))
+    {
+        Obj copy = ELM_REC(options, rcopy);
+        std::string mode = IS_STRING_REP(copy) ? CONST_CSTR_STRING(copy) : "";
+        if(mode == "reference")
+            h.copy = CopyReference;
+        else if(mode == "shallow")
+            h.copy = CopyShallow;
+        else if(mode == "summary")
+            h.copy = CopySummary;
+        else
+        {
+            ErrorMayQuit("Breakpoint option 'copy' must be \"reference\", "
+                         "\"shallow\" or \"summary\"",0,0);
+        }
+    }
+    return true;
+}
+
+UInt breakpointHistorySlots(Obj options)
+{
+    BreakpointHistory h;
+    if(!readHistoryOptions(options, h))
+        return 0;
+    return h.size * (h.vars.size() + 1);
+}
+
+void checkBreakpointHistorySlots(UInt slots)
+{
+    if(slots > HISTORY_MAX_SLOTS || history_slots + slots > HISTORY_MAX_SLOTS)
+    {
+        ErrorMayQuit("Breakpoint histories would use too much memory",0,0);
+    }
+}
+
+Int newBreakpointHistory(Obj options)
+{
+    BreakpointHistory h;
+    if(!readHistoryOptions(options, h))
+        return 0;
+    UInt slots = h.size * (h.vars.size() + 1);
+    checkBreakpointHistorySlots(slots);
+    history_slots += slots;
+    h.recorded = 0;
+    h.bytes = 0;
+    h.in_use = true;
+    histories.push_back(h);
+    AssPlist(history_rings, histories.size(), NEW_PLIST(T_PLIST, 0));
+    return histories.size();
+}
+
+static const char* copyModeName(HistoryCopy copy)
+{
+    switch(copy)
+    {
+    case CopyReference:
+        return "reference";
+    case CopySummary:
+        return "summary";
+    default:
+        return "shallow";
+    }
+}
+
+std::string savedBreakpointHistory(Int id)
+{
+    const BreakpointHistory& h = histories[id - 1];
+    std::string out = std::to_string((unsigned long long)h.size) + "," +
+                      copyModeName(h.copy) + "," +
+                      std::to_string((unsigned long long)h.copy_limit);
+    for(UInt i = 0; i < h.vars.size(); ++i)
+        out += "," + h.vars[i].name();
+    return out;
+}
+
+bool readSavedBreakpointHistory(const std::string& text, Obj options)
+{
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    for(;;)
+    {
+        size_t comma = text.find(',', pos);
+        fields.push_back(text.substr(pos, comma - pos));
+        if(comma == std::string::npos)
+            break;
+        pos = comma + 1;
+    }
+    if(fields.size() < 4)
+        return false;
+    UInt numbers[2];
+    const std::string* numfields[2] = { &fields[0], &fields[2] };
+    for(int i = 0; i < 2; ++i)
+    {
+        char* end;
+        numbers[i] = strtoul(numfields[i]->c_str(), &end, 10);
+        if(numfields[i]->empty() || *end != 0 || numbers[i] == 0 ||
+           numbers[i] > (UInt)INT_INTOBJ_MAX)
+            return false;
+    }
+    Obj names = NEW_PLIST(T_PLIST, fields.size() - 3);
+    for(UInt i = 3; i < fields.size(); ++i)
+    {
+        if(fields[i].empty())
+            return false;
+        PushPlist(names, MakeString(fields[i].c_str()));
+    }
+    AssPRec(options, RNamName("capture"), names);
+    AssPRec(options, RNamName("history"), INTOBJ_INT(numbers[0]));
+    AssPRec(options, RNamName("copy"), MakeString(fields[1].c_str()));
+    AssPRec(options, RNamName("copyLimit"), INTOBJ_INT(numbers[1]));
+    return true;
+}
+
+// A short description of a value, which does not refer to it
+static Obj summarise(Obj val)
+{
+    std::string text = "<";
+    text += TNAM_OBJ(val);
+    text += ", " + std::to_string((unsigned long long)SIZE_OBJ(val)) + " bytes>";
+    return MakeImmString(text.c_str());
+}
+
+// The bytes of a value held by a history
+static UInt valueBytes(Obj val)
+{
+    return (val && IS_BAG_REF(val)) ? SIZE_OBJ(val) : 0;
+}
+
+static Obj captureValue(const BreakpointHistory& h, Obj val)
+{
+    if(!val || !IS_BAG_REF(val))
+        return val;
+    // A shallow copy is the same size as the value it copies
+    if(h.copy == CopySummary ||
+       history_bytes + SIZE_OBJ(val) > HISTORY_MAX_BYTES)
+        return summarise(val);
+    if(h.copy == CopyReference || !IS_MUTABLE_OBJ(val))
+        return val;
+    if(SIZE_OBJ(val) > h.copy_limit)
+        return summarise(val);
+    disable_debugger = 1;
+    val = SHALLOW_COPY_OBJ(val);
+    disable_debugger = 0;
+    return val;
+}
+
+void breakpointHistoryRecord(Int id, UInt hit)
+{
+    BreakpointHistory& h = histories[id - 1];
+    Obj ring = ELM_PLIST(history_rings, id);
+    UInt slot = h.recorded % h.size + 1;
+    UInt len = h.vars.size() + 1;
+    Obj entry = (slot <= (UInt)LEN_PLIST(ring)) ? ELM_PLIST(ring, slot) : 0;
+    if(!entry)
+    {
+        entry = NEW_PLIST(T_PLIST, len);
+        SET_LEN_PLIST(entry, len);
+        AssPlist(ring, slot, entry);
+        h.slot_bytes.push_back(0);
+    }
+    // The values being overwritten are no longer held
+    h.bytes -= h.slot_bytes[slot - 1];
+    history_bytes -= h.slot_bytes[slot - 1];
+    h.slot_bytes[slot - 1] = 0;
+    SET_ELM_PLIST(entry, 1, ObjInt_UInt(hit));
+    for(UInt i = 0; i < h.vars.size(); ++i)
+    {
+        Obj val = captureValue(h, h.vars[i].read());
+        SET_ELM_PLIST(entry, i + 2, val);
+        CHANGED_BAG(entry);
+        UInt bytes = valueBytes(val);
+        h.slot_bytes[slot - 1] += bytes;
+        h.bytes += bytes;
+        history_bytes += bytes;
+    }
+    h.recorded++;
+}
+
+Obj breakpointHistory(Int id)
+{
+    const BreakpointHistory& h = histories[id - 1];
+    Obj ring = ELM_PLIST(history_rings, id);
+    UInt count = h.recorded < h.size ? h.recorded : h.size;
+    Obj list = NEW_PLIST(T_PLIST, count);
+    for(UInt i = 0; i < count; ++i)
+    {
+        // The oldest entry is in the slot which would be written next
+        UInt slot = (h.recorded - count + i) % h.size + 1;
+        Obj entry = ELM_PLIST(ring, slot);
+        Obj values = NEW_PREC(h.vars.size());
+        for(UInt j = 0; j < h.vars.size(); ++j)
+        {
+            Obj val = ELM_PLIST(entry, j + 2);
+            if(val)
+                AssPRec(values, RNamName(h.vars[j].name().c_str()), val);
+        }
+        Obj rec = NEW_PREC(2);
+        AssPRec(rec, RNamName("hit"), ELM_PLIST(entry, 1));
+        AssPRec(rec, RNamName("values"), values);
+        PushPlist(list, rec);
+    }
+    return list;
+}
+
+void keepBreakpointHistories(const std::vector<Int>& ids)
+{
+    std::vector<bool> keep(histories.size() + 1, false);
+    for(UInt i = 0; i < ids.size(); ++i)
+        keep[ids[i]] = true;
+    for(UInt i = 0; i < histories.size(); ++i)
+    {
+        BreakpointHistory& h = histories[i];
+        if(!h.in_use || keep[i + 1])
+            continue;
+        h.in_use = false;
+        history_slots -= h.size * (h.vars.size() + 1);
+        history_bytes -= h.bytes;
+        h.vars.clear();
+        h.slot_bytes.clear();
+        SET_ELM_PLIST(history_rings, i + 1, NEW_PLIST(T_PLIST, 0));
+        CHANGED_BAG(history_rings);
+    }
+    // Ids are positions, so we can only reuse them once none are kept
+    if(ids.empty())
+    {
+        histories.clear();
+        history_slots = 0;
+        history_bytes = 0;
+        history_rings = NEW_PLIST(T_PLIST, 0);
+    }
+}
+
+Int InitKernelHistory()
+{
+    InitGlobalBag(&history_rings, "src/history.cc:history_rings");
+    return 0;
+}
+
+Int InitLibraryHistory()
+{
+    history_rings = NEW_PLIST(T_PLIST, 0);
+    return 0;
+}
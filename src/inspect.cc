@@ -0,0 +1,338 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * Describing the values of local variables in the break loop, without
+ * printing them in full. Lists, records and strings are written out
+ * natively, stopping once a budget of characters or list elements is
+ * used up. Other values are only given to GAP's ViewString when they are
+ * small enough that viewing them should be quick.
+ */
+
+#include "debugger.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Stop measuring the memory used by a value after this many bags
+#define FOOTPRINT_MAX_BAGS 100000
+
+// Do not write out lists and records nested deeper than this
+#define DESCRIBE_MAX_DEPTH 4
+
+// The number of bytes used by 'val' and the bags it refers to through
+// lists, records and objects, counting each bag once. 'complete' is set
+// to false if we gave up before reaching every bag.
+static UInt8 footprint(Obj val, bool& complete)
+{
+    std::unordered_set<Obj> seen;
+    std::vector<Obj> todo(1, val);
+    UInt8 bytes = 0;
+    complete = true;
+    while(!todo.empty())
+    {
+        Obj obj = todo.back();
+        todo.pop_back();
+        if(!obj || !IS_BAG_REF(obj) || !seen.insert(obj).second)
+            continue;
+        if(seen.size() > FOOTPRINT_MAX_BAGS)
+        {
+            complete = false;
+            break;
+        }
+        bytes += SIZE_OBJ(obj);
+        if(TNUM_OBJ(obj) == T_POSOBJ)
+        {
+            // The first entry is the type, which is shared
+            UInt len = SIZE_OBJ(obj) / sizeof(Obj);
+            for(UInt i = 1; i < len; ++i)
+                todo.push_back(CONST_ADDR_OBJ(obj)[i]);
+        }
+        else if(TNUM_OBJ(obj) == T_COMOBJ || IS_PREC(obj))
+        {
+            for(UInt i = 1; i <= LEN_PREC(obj); ++i)
+                todo.push_back(GET_ELM_PREC(obj, i));
+        }
+        else if(IS_PLIST(obj))
+        {
+            for(Int i = 1; i <= LEN_PLIST(obj); ++i)
+                todo.push_back(ELM_PLIST(obj, i));
+        }
+    }
+    return bytes;
+}
+
+// Writes values into 'out', until more than 'max_bytes' characters have
+// been written. At most 'max_elements' entries of each list and record
+// are written.
+class ValueWriter
+{
+    std::string& out;
+    UInt max_bytes;
+    UInt max_elements;
+
+    bool full() const
+    { return out.size() >= max_bytes; }
+
+    void writeString(Obj str)
+    {
+        UInt len = GET_LEN_STRING(str);
+        const char* chars = CONST_CSTR_STRING(str);
+        out += '"';
+        UInt i;
+        for(i = 0; i < len && !full(); ++i)
+        {
+            char c = chars[i];
+            if(c == '"' || c == '\\')
+                out += '\\';
+            if(c == '\n')
+                out += "\\n";
+            else
+                out += c;
+        }
+        out += '"';
+        if(i < len)
+            out += " (" + std::to_string((unsigned long long)len) + " characters)";
+    }
+
+    void writeList(Obj list, int depth)
+    {
+        Int len = LEN_PLIST(list);
+        if(depth >= DESCRIBE_MAX_DEPTH && len > 0)
+        {
+            out += "[ ... ]";
+            return;
+        }
+        out += "[ ";
+        Int i;
+        for(i = 1; i <= len && (UInt)i <= max_elements && !full(); ++i)
+        {
+            if(i > 1)
+                out += ", ";
+            Obj elm = ELM_PLIST(list, i);
+            if(elm)
+                write(elm, depth + 1);
+        }
+        if(i <= len)
+            out += ", ... (" + std::to_string((long long)len) + " elements)";
+        out += " ]";
+    }
+
+    void writeRecord(Obj record, int depth)
+    {
+        UInt len = LEN_PREC(record);
+        if(depth >= DESCRIBE_MAX_DEPTH && len > 0)
+        {
+            out += "rec( ... )";
+            return;
+        }
+        out += "rec( ";
+        UInt i;
+        for(i = 1; i <= len && i <= max_elements && !full(); ++i)
+        {
+            if(i > 1)
+                out += ", ";
+            Obj name = NAME_RNAM(labs(GET_RNAM_PREC(record, i)));
+            out.append(CONST_CSTR_STRING(name), GET_LEN_STRING(name));
+            out += " := ";
+            write(GET_ELM_PREC(record, i), depth + 1);
+        }
+        if(i <= len)
+            out += ", ... (" + std::to_string((unsigned long long)len) + " components)";
+        out += " )";
+    }
+
+    // Values we do not understand are viewed by GAP, if they are small
+    void writeOther(Obj val)
+    {
+        bool complete;
+        UInt8 bytes = footprint(val, complete);
+        if(!complete || bytes > max_bytes)
+        {
+            out += "<";
+            out += TNAM_OBJ(val);
+            out += ">";
+            return;
+        }
+        disable_debugger = 1;
+        Obj str = CALL_1ARGS(VAL_GVAR(GVarName("ViewString")), val);
+        disable_debugger = 0;
+        if(!str || !IS_STRING_REP(str))
+        {
+            out += "<";
+            out += TNAM_OBJ(val);
+            out += ">";
+            return;
+        }
+        UInt len = GET_LEN_STRING(str);
+        UInt room = max_bytes > out.size() ? max_bytes - out.size() : 0;
+        if(len <= room)
+            out.append(CONST_CSTR_STRING(str), len);
+        else
+        {
+            out.append(CONST_CSTR_STRING(str), room);
+            out += "...";
+        }
+    }
+
+public:
+    ValueWriter(std::string& out_, UInt max_bytes_, UInt max_elements_)
+    : out(out_), max_bytes(max_bytes_), max_elements(max_elements_)
+    { }
+
+    void write(Obj val, int depth = 0)
+    {
+        if(full())
+        {
+            out += "...";
+            return;
+        }
+        if(IS_INTOBJ(val))
+            out += std::to_string((long long)INT_INTOBJ(val));
+        else if(val == True)
+            out += "true";
+        else if(val == False)
+            out += "false";
+        else if(val == Fail)
+            out += "fail";
+        else if(IS_STRING_REP(val))
+            writeString(val);
+        else if(IS_PLIST(val))
+            writeList(val, depth);
+        else if(IS_PREC(val))
+            writeRecord(val, depth);
+        else
+            writeOther(val);
+    }
+};
+
+// Write 'val', followed by its type and size
+static void describeValue(std::string& out, Obj val, UInt max_bytes, UInt max_elements)
+{
+    if(!val)
+    {
+        out += "<unbound>";
+        return;
+    }
+    std::string text;
+    ValueWriter(text, max_bytes, max_elements).write(val);
+    out += text;
+    out += " (";
+    out += TNAM_OBJ(val);
+    if(IS_BAG_REF(val))
+    {
+        bool complete;
+        UInt8 bytes = footprint(val, complete);
+        out += complete ? ", " : ", at least ";
+        out += std::to_string((unsigned long long)bytes) + " bytes";
+    }
+    out += ")";
+}
+
+static void checkLimits(Obj bytes, Obj elements)
+{
+    if(!IS_POS_INTOBJ(bytes) || !IS_POS_INTOBJ(elements))
+    {
+        ErrorMayQuit("The limits on bytes and elements must be positive integers",0,0);
+    }
+}
+
+static void checkLVars(Obj lvars)
+{
+    if(!IS_BAG_REF(lvars) || TNUM_OBJ(lvars) != T_LVARS || IsBottomLVars(lvars))
+    {
+        ErrorMayQuit("ShowLocals unable to read local variables",0,0);
+    }
+}
+
+// A description of the arguments and local variables in 'lvars'
+static Obj FuncSHOW_LOCALS(Obj self, Obj lvars, Obj bytes, Obj elements)
+{
+    checkLVars(lvars);
+    checkLimits(bytes, elements);
+    Obj func = FUNC_LVARS(lvars);
+    Obj names = NAMS_FUNC(func);
+    Int count = names ? LEN_PLIST(names) : 0;
+    Int argcount = NARG_FUNC(func);
+    std::string out;
+    if(argcount < 0)
+    {
+        argcount = -argcount;
+        out += "Variadic function with at least " +
+               std::to_string((long long)argcount - 1) + " arguments\n";
+    }
+    else
+        out += "Function with " + std::to_string((long long)argcount) + " arguments\n";
+    for(Int i = 1; i <= count; ++i)
+    {
+        if(i == argcount + 1)
+            out += "Local variables:\n";
+        Obj name = ELM_PLIST(names, i);
+        out += " ";
+        out.append(CONST_CSTR_STRING(name), GET_LEN_STRING(name));
+        out += ": ";
+        describeValue(out, OBJ_HVAR_WITH_CONTEXT(lvars, i), INT_INTOBJ(bytes),
+                      INT_INTOBJ(elements));
+        out += "\n";
+    }
+    if(argcount >= count)
+        out += "Local variables:\n";
+    return MakeString(out.c_str());
+}
+
+// The value of the argument or local variable 'name' in 'lvars'
+static Obj FuncLVARS_VALUE(Obj self, Obj lvars, Obj name)
+{
+    checkLVars(lvars);
+    if(!IS_STRING_REP(name))
+    {
+        ErrorMayQuit("Variable name must be a string",0,0);
+    }
+    Obj names = NAMS_FUNC(FUNC_LVARS(lvars));
+    Int count = names ? LEN_PLIST(names) : 0;
+    for(Int i = 1; i <= count; ++i)
+    {
+        if(strcmp(CONST_CSTR_STRING(ELM_PLIST(names, i)), CONST_CSTR_STRING(name)) == 0)
+        {
+            Obj val = OBJ_HVAR_WITH_CONTEXT(lvars, i);
+            if(!val)
+            {
+                ErrorMayQuit("Variable '%s' is unbound", (Int)CONST_CSTR_STRING(name),0);
+            }
+            return val;
+        }
+    }
+    ErrorMayQuit("No local variable '%s'", (Int)CONST_CSTR_STRING(name),0);
+    return 0;
+}
+
+static Obj FuncDESCRIBE_VALUE(Obj self, Obj val, Obj bytes, Obj elements)
+{
+    checkLimits(bytes, elements);
+    std::string out;
+    describeValue(out, val, INT_INTOBJ(bytes), INT_INTOBJ(elements));
+    return MakeString(out.c_str());
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(SHOW_LOCALS, 3, "lvars, bytes, elements"),
+    GVAR_FUNC(LVARS_VALUE, 2, "lvars, name"),
+    GVAR_FUNC(DESCRIBE_VALUE, 3, "val, bytes, elements"),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelInspect()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    return 0;
+}
+
+Int InitLibraryInspect()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    return 0;
+}
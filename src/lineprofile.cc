@@ -0,0 +1,126 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * A native line profiler, which counts how often each line is executed
+ * and how much time is spent on it, without calling any GAP code.
+ */
+
+#include "debugger.h"
+#include "timer.hpp"
+
+#include <vector>
+
+bool line_profile_active;
+
+struct LineCounts
+{
+    uint64_t hits;
+    uint64_t ticks;
+};
+
+// Counts for each line, indexed first by file id, then by line
+static std::vector<std::vector<LineCounts> > line_counts;
+
+// The previous line we visited, which is charged for the time until the
+// next statement starts.
+static Int prev_file;
+static Int prev_line;
+static uint64_t prev_ticks;
+
+static TickCalibration line_calibration;
+
+void lineProfileVisitStat(Int file, Int line)
+{
+    uint64_t now = readTicks();
+    if(prev_file != 0)
+        line_counts[prev_file][prev_line].ticks += now - prev_ticks;
+
+    if((UInt)file >= line_counts.size())
+        line_counts.resize(file + 1);
+    std::vector<LineCounts>& counts = line_counts[file];
+    if((UInt)line >= counts.size())
+        counts.resize(line + 1, LineCounts());
+    counts[line].hits++;
+
+    prev_file = file;
+    prev_line = line;
+    prev_ticks = now;
+}
+
+static Obj FuncSTART_LINE_PROFILE(Obj self)
+{
+    if(line_counts.empty())
+        line_calibration.reset();
+    line_profile_active = true;
+    prev_file = 0;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncSTOP_LINE_PROFILE(Obj self)
+{
+    line_profile_active = false;
+    prev_file = 0;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncCLEAR_LINE_PROFILE(Obj self)
+{
+    line_counts.clear();
+    line_calibration.reset();
+    prev_file = 0;
+    return 0;
+}
+
+static Obj FuncGET_LINE_PROFILE(Obj self)
+{
+    double scale = line_calibration.nanosPerTick();
+    Obj files = NEW_PLIST(T_PLIST, 0);
+    Obj lines = NEW_PLIST(T_PLIST, 0);
+    Obj hits = NEW_PLIST(T_PLIST, 0);
+    Obj times = NEW_PLIST(T_PLIST, 0);
+    for(UInt file = 1; file < line_counts.size(); ++file)
+    {
+        if(line_counts[file].empty())
+            continue;
+        Obj filename = GetCachedFilename(file);
+        for(UInt line = 1; line < line_counts[file].size(); ++line)
+        {
+            const LineCounts& c = line_counts[file][line];
+            if(c.hits == 0)
+                continue;
+            PushPlist(files, filename);
+            PushPlist(lines, INTOBJ_INT(line));
+            PushPlist(hits, ObjInt_UInt8(c.hits));
+            PushPlist(times, ObjInt_UInt8((UInt8)(c.ticks * scale)));
+        }
+    }
+    Obj rec = NEW_PREC(4);
+    AssPRec(rec, RNamName("file"), files);
+    AssPRec(rec, RNamName("line"), lines);
+    AssPRec(rec, RNamName("hits"), hits);
+    AssPRec(rec, RNamName("time"), times);
+    return rec;
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(START_LINE_PROFILE, 0, ""),
+    GVAR_FUNC(STOP_LINE_PROFILE, 0, ""),
+    GVAR_FUNC(CLEAR_LINE_PROFILE, 0, ""),
+    GVAR_FUNC(GET_LINE_PROFILE, 0, ""),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelLineProfile()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    return 0;
+}
+
+Int InitLibraryLineProfile()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    return 0;
+}
@@ -0,0 +1,439 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * Logpoints: locations which, instead of stopping, log a message built
+ * from a template such as "i = {i}, total = {total}". When a logpoint is
+ * reached we only copy the values of its variables into a buffer. Turning
+ * them into text, and writing the text out, is done a whole buffer at a
+ * time, so logging a line in a tight loop does not wait for the terminal
+ * or the disk on every hit.
+ *
+ * Small integers, booleans, characters and strings are copied into the
+ * buffer. Other values are formatted with String when the buffer is
+ * written out, so mutable ones are shallow copied when the logpoint is
+ * reached, to show their value at that time. Mutable values larger than
+ * LOGPOINT_COPY_LIMIT are only summarised, as breakpoint histories do.
+ *
+ * A logpoint logs once each time its line is reached, not once for each
+ * statement on the line. A new call always reaches its first line, even
+ * if the previous call ended on the same line.
+ */
+
+#include "debugger.h"
+#include "breakpoint_index.hpp"
+#include "variables.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+bool logpoint_active;
+
+// Captured values are formatted once the buffer reaches this size, or
+// the values copied for it reach LOGPOINT_COPY_BUFFER_SIZE bytes
+#define LOGPOINT_BUFFER_SIZE (1 << 16)
+#define LOGPOINT_COPY_BUFFER_SIZE (1 << 22)
+
+// Mutable values larger than this are summarised rather than copied
+#define LOGPOINT_COPY_LIMIT 65536
+
+// A piece of a template: some text, followed by the value of a variable
+// (unless this is the last piece)
+struct LogSegment
+{
+    std::string text;
+    VariableRef var;
+};
+
+struct Logpoint
+{
+    Int file;
+    Int line;
+    std::vector<LogSegment> segments;
+};
+
+static std::vector<Logpoint> logpoints;
+static BreakpointIndex logpoint_index;
+
+// How each value is stored in the buffer
+enum LogTag
+{
+    LogUnbound, LogInt, LogTrue, LogFalse, LogFail, LogChar, LogString, LogObject
+};
+
+// Each hit is stored as the position of the logpoint, followed by a tag
+// and data for each variable in its template
+static std::vector<unsigned char> log_buffer;
+
+// Values to be formatted, in a GAP list so the GC sees them
+static Obj log_objects;
+// The bytes of the values copied into log_objects
+static UInt log_copied_bytes;
+
+// The last location a logpoint was checked for, or (0, 0) at the start
+// of a call
+static std::pair<Int, Int> log_prevlocation;
+
+// Messages formatted but not yet drained, when no file is set
+static Obj log_messages;
+
+static FILE* log_out;
+static bool log_write_failed;
+
+template<typename T>
+static void putValue(const T& val)
+{
+    const unsigned char* p = (const unsigned char*)&val;
+    log_buffer.insert(log_buffer.end(), p, p + sizeof(T));
+}
+
+template<typename T>
+static T getValue(const unsigned char*& p)
+{
+    T val;
+    memcpy(&val, p, sizeof(T));
+    p += sizeof(T);
+    return val;
+}
+
+static void putString(const char* chars, UInt len)
+{
+    log_buffer.push_back(LogString);
+    putValue<UInt>(len);
+    log_buffer.insert(log_buffer.end(), chars, chars + len);
+}
+
+static void captureValue(Obj val)
+{
+    if(!val)
+        log_buffer.push_back(LogUnbound);
+    else if(IS_INTOBJ(val))
+    {
+        log_buffer.push_back(LogInt);
+        putValue<Int>(INT_INTOBJ(val));
+    }
+    else if(val == True)
+        log_buffer.push_back(LogTrue);
+    else if(val == False)
+        log_buffer.push_back(LogFalse);
+    else if(val == Fail)
+        log_buffer.push_back(LogFail);
+    else if(TNUM_OBJ(val) == T_CHAR)
+    {
+        log_buffer.push_back(LogChar);
+        log_buffer.push_back(CHAR_VALUE(val));
+    }
+    else if(IS_STRING_REP(val))
+    {
+        // Strings can be changed in place, so copy them
+        putString(CONST_CSTR_STRING(val), GET_LEN_STRING(val));
+    }
+    else if(IS_MUTABLE_OBJ(val) && SIZE_OBJ(val) > LOGPOINT_COPY_LIMIT)
+    {
+        std::string text = "<";
+        text += TNAM_OBJ(val);
+        text += ", " + std::to_string((unsigned long long)SIZE_OBJ(val)) + " bytes>";
+        putString(text.data(), text.size());
+    }
+    else
+    {
+        if(IS_MUTABLE_OBJ(val))
+        {
+            disable_debugger = 1;
+            val = SHALLOW_COPY_OBJ(val);
+            disable_debugger = 0;
+            log_copied_bytes += SIZE_OBJ(val);
+        }
+        log_buffer.push_back(LogObject);
+        PushPlist(log_objects, val);
+        putValue<UInt>(LEN_PLIST(log_objects));
+    }
+}
+
+static void appendObject(std::string& out, Obj val)
+{
+    disable_debugger = 1;
+    Obj str = CALL_1ARGS(VAL_GVAR(GVarName("String")), val);
+    disable_debugger = 0;
+    if(str && IS_STRING_REP(str))
+        out.append(CONST_CSTR_STRING(str), GET_LEN_STRING(str));
+    else
+        out += "<object>";
+}
+
+// Turn every captured hit into text, and write it to the log file or
+// add it to log_messages. Returns the number of messages.
+static UInt formatLogBuffer()
+{
+    if(log_buffer.empty())
+        return 0;
+    // Take the buffer, in case String runs code which reaches a logpoint
+    std::vector<unsigned char> buffer;
+    buffer.swap(log_buffer);
+    Obj objects = log_objects;
+    log_objects = NEW_PLIST(T_PLIST, 0);
+    log_copied_bytes = 0;
+
+    std::string text;
+    std::string message;
+    UInt count = 0;
+    const unsigned char* p = buffer.data();
+    const unsigned char* end = p + buffer.size();
+    while(p < end)
+    {
+        const Logpoint& lp = logpoints[getValue<UInt>(p)];
+        message.clear();
+        for(UInt i = 0; i < lp.segments.size(); ++i)
+        {
+            message += lp.segments[i].text;
+            if(lp.segments[i].var.empty())
+                continue;
+            switch(*p++)
+            {
+            case LogUnbound:
+                message += "<unbound>";
+                break;
+            case LogInt:
+                message += std::to_string((long long)getValue<Int>(p));
+                break;
+            case LogTrue:
+                message += "true";
+                break;
+            case LogFalse:
+                message += "false";
+                break;
+            case LogFail:
+                message += "fail";
+                break;
+            case LogChar:
+                message += (char)*p++;
+                break;
+            case LogString:
+            {
+                UInt len = getValue<UInt>(p);
+                message.append((const char*)p, len);
+                p += len;
+                break;
+            }
+            case LogObject:
+                appendObject(message, ELM_PLIST(objects, getValue<UInt>(p)));
+                break;
+            }
+        }
+        if(log_out)
+        {
+            text += message;
+            text += '\n';
+        }
+        else
+            PushPlist(log_messages, MakeString(message.c_str()));
+        count++;
+    }
+    if(log_out && fwrite(text.data(), 1, text.size(), log_out) != text.size())
+        log_write_failed = true;
+    if(log_buffer.empty())
+    {
+        buffer.clear();
+        buffer.swap(log_buffer);
+    }
+    return count;
+}
+
+void logpointVisitStat(Int file, Int line)
+{
+    std::pair<Int, Int> location(file, line);
+    if(log_prevlocation == location)
+        return;
+    log_prevlocation = location;
+    const std::vector<Int>* hits = logpoint_index.find(file, line);
+    if(!hits)
+        return;
+    for(UInt i = 0; i < hits->size(); ++i)
+    {
+        const Logpoint& lp = logpoints[(*hits)[i]];
+        putValue<UInt>((*hits)[i]);
+        for(UInt j = 0; j < lp.segments.size(); ++j)
+        {
+            if(!lp.segments[j].var.empty())
+                captureValue(lp.segments[j].var.read());
+        }
+    }
+    if(log_buffer.size() >= LOGPOINT_BUFFER_SIZE ||
+       log_copied_bytes >= LOGPOINT_COPY_BUFFER_SIZE)
+        formatLogBuffer();
+}
+
+void logpointEnterFunction()
+{
+    log_prevlocation = std::pair<Int, Int>(0, 0);
+}
+
+// Split a template into segments. '{name}' is replaced by the value of
+// the variable 'name', and '{{' and '}}' stand for '{' and '}'.
+static std::vector<LogSegment> parseTemplate(const char* str)
+{
+    std::vector<LogSegment> segments(1);
+    for(const char* p = str; *p; ++p)
+    {
+        if(*p == '}')
+        {
+            if(p[1] != '}')
+            {
+                ErrorMayQuit("Logpoint template has an unmatched '}'",0,0);
+            }
+            segments.back().text += '}';
+            ++p;
+        }
+        else if(*p != '{')
+            segments.back().text += *p;
+        else if(p[1] == '{')
+        {
+            segments.back().text += '{';
+            ++p;
+        }
+        else
+        {
+            const char* close = strchr(p, '}');
+            if(!close)
+            {
+                ErrorMayQuit("Logpoint template has an unclosed '{'",0,0);
+            }
+            if(close == p + 1)
+            {
+                ErrorMayQuit("Logpoint template has an empty '{}'",0,0);
+            }
+            segments.back().var = VariableRef(std::string(p + 1, close));
+            segments.push_back(LogSegment());
+            p = close;
+        }
+    }
+    return segments;
+}
+
+static Obj FuncADD_LOGPOINT(Obj self, Obj file, Obj line, Obj templ)
+{
+    if(!IS_POS_INTOBJ(file) || !IS_POS_INTOBJ(line) || !IS_STRING_REP(templ))
+    {
+        ErrorMayQuit("Usage: ADD_LOGPOINT(file, line, template)",0,0);
+    }
+    Logpoint lp;
+    lp.file = INT_INTOBJ(file);
+    lp.line = INT_INTOBJ(line);
+    lp.segments = parseTemplate(CONST_CSTR_STRING(templ));
+    logpoint_index.add(lp.file, lp.line, logpoints.size());
+    logpoints.push_back(lp);
+    logpoint_active = true;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncCLEAR_LOGPOINTS(Obj self)
+{
+    // Hits already captured refer to the logpoints, so format them first
+    formatLogBuffer();
+    logpoints.clear();
+    logpoint_index.clear();
+    logpoint_active = false;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncGET_LOGPOINTS(Obj self)
+{
+    Obj list = NEW_PLIST(T_PLIST, logpoints.size());
+    for(UInt i = 0; i < logpoints.size(); ++i)
+    {
+        Obj entry = NEW_PLIST(T_PLIST, 2);
+        PushPlist(entry, INTOBJ_INT(logpoints[i].file));
+        PushPlist(entry, INTOBJ_INT(logpoints[i].line));
+        PushPlist(list, entry);
+    }
+    return list;
+}
+
+static void closeLogFile()
+{
+    if(!log_out)
+        return;
+    if(fclose(log_out) != 0)
+        log_write_failed = true;
+    log_out = 0;
+    if(log_write_failed)
+    {
+        ErrorMayQuit("Error writing logpoint file",0,0);
+    }
+}
+
+// Write messages to 'filename' from now on, or keep them for
+// DRAIN_LOGPOINTS if 'filename' is fail
+static Obj FuncSET_LOGPOINT_FILE(Obj self, Obj filename)
+{
+    if(filename != Fail && !IS_STRING_REP(filename))
+    {
+        ErrorMayQuit("Usage: SetLogpointFile(filename)",0,0);
+    }
+    // Messages captured so far go to the old destination
+    formatLogBuffer();
+    closeLogFile();
+    if(filename == Fail)
+        return 0;
+    log_out = fopen(CONST_CSTR_STRING(filename), "w");
+    if(!log_out)
+    {
+        ErrorMayQuit("Unable to open logpoint file '%s'",
+                     (Int)CONST_CSTR_STRING(filename),0);
+    }
+    log_write_failed = false;
+    return 0;
+}
+
+// Format everything captured so far. Returns the number of messages.
+static Obj FuncFLUSH_LOGPOINTS(Obj self)
+{
+    UInt count = formatLogBuffer();
+    if(log_out && fflush(log_out) != 0)
+        log_write_failed = true;
+    if(log_write_failed)
+    {
+        ErrorMayQuit("Error writing logpoint file",0,0);
+    }
+    return INTOBJ_INT(count);
+}
+
+static Obj FuncDRAIN_LOGPOINTS(Obj self)
+{
+    formatLogBuffer();
+    Obj messages = log_messages;
+    log_messages = NEW_PLIST(T_PLIST, 0);
+    return messages;
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(ADD_LOGPOINT, 3, "file, line, template"),
+    GVAR_FUNC(CLEAR_LOGPOINTS, 0, ""),
+    GVAR_FUNC(GET_LOGPOINTS, 0, ""),
+    GVAR_FUNC(SET_LOGPOINT_FILE, 1, "filename"),
+    GVAR_FUNC(FLUSH_LOGPOINTS, 0, ""),
+    GVAR_FUNC(DRAIN_LOGPOINTS, 0, ""),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelLogpoint()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    InitGlobalBag(&log_objects, "src/logpoint.cc:log_objects");
+    InitGlobalBag(&log_messages, "src/logpoint.cc:log_messages");
+    return 0;
+}
+
+Int InitLibraryLogpoint()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    log_objects = NEW_PLIST(T_PLIST, 0);
+    log_messages = NEW_PLIST(T_PLIST, 0);
+    return 0;
+}
@@ -0,0 +1,212 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * A statistical profiler. A SIGPROF timer sets a flag, and the next time
+ * GAP reaches one of our hooks we record the current call stack. This keeps
+ * the cost when no sample is wanted to a single test of the flag.
+ */
+
+#include "debugger.h"
+#include "function_table.hpp"
+
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+volatile sig_atomic_t sample_pending;
+
+bool sample_profile_active;
+
+static FunctionTable sampled_functions;
+
+// We never record more than this many frames of a single stack
+#define MAX_SAMPLE_DEPTH 256
+
+// Stacks are stored one after another in sample_buffer, each as the
+// number of frames, the line being executed in the innermost frame, and
+// then the function of each frame, innermost first. The buffer is allocated
+// when sampling starts. If it fills up, further samples are dropped.
+static std::vector<Int> sample_buffer;
+static UInt sample_buffer_capacity = 1 << 22;
+static UInt dropped_samples;
+
+static struct sigaction old_sigprof_action;
+
+extern "C" {
+static void handleSigprof(int signum)
+{ sample_pending = 1; }
+}
+
+void samplingTakeSample(Int line)
+{
+    sample_pending = 0;
+    if(sample_buffer.size() + MAX_SAMPLE_DEPTH + 2 > sample_buffer_capacity)
+    {
+        dropped_samples++;
+        return;
+    }
+
+    UInt start = sample_buffer.size();
+    sample_buffer.push_back(0);
+    sample_buffer.push_back(line);
+    Int depth = 0;
+    Obj lvars = STATE(CurrLVars);
+    while(!IsBottomLVars(lvars) && depth < MAX_SAMPLE_DEPTH)
+    {
+        sample_buffer.push_back(sampled_functions.lookup(FUNC_LVARS(lvars)));
+        depth++;
+        lvars = PARENT_LVARS(lvars);
+    }
+    if(depth == 0)
+        sample_buffer.resize(start);
+    else
+        sample_buffer[start] = depth;
+}
+
+static void setSampleTimer(Int usec)
+{
+    struct itimerval timer;
+    timer.it_interval.tv_sec = usec / 1000000;
+    timer.it_interval.tv_usec = usec % 1000000;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, 0);
+}
+
+static Obj FuncSTART_SAMPLE_PROFILE(Obj self, Obj interval)
+{
+    if(!IS_POS_INTOBJ(interval))
+    {
+        ErrorMayQuit("Sample interval must be a positive integer (microseconds)",0,0);
+    }
+    if(sample_profile_active)
+    {
+        ErrorMayQuit("Sample profile is already running",0,0);
+    }
+    sample_buffer.reserve(sample_buffer_capacity);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handleSigprof;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGPROF, &action, &old_sigprof_action);
+
+    sample_pending = 0;
+    sample_profile_active = true;
+    setSampleTimer(INT_INTOBJ(interval));
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncSTOP_SAMPLE_PROFILE(Obj self)
+{
+    if(!sample_profile_active)
+        return 0;
+    setSampleTimer(0);
+    sigaction(SIGPROF, &old_sigprof_action, 0);
+    sample_profile_active = false;
+    sample_pending = 0;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncCLEAR_SAMPLE_PROFILE(Obj self)
+{
+    sample_buffer.clear();
+    sampled_functions.clear();
+    dropped_samples = 0;
+    return 0;
+}
+
+// Describe a function as 'name (file:line)'. Semicolons separate frames
+// in the folded stack format, so are replaced.
+static std::string describeFrame(Obj func, Int line)
+{
+    std::string s;
+    Obj name = NAME_FUNC(func);
+    if(name && IS_STRING_REP(name))
+        s = CONST_CSTR_STRING(name);
+    else
+        s = "<anonymous>";
+    Obj body = BODY_FUNC(func);
+    Obj filename = GET_FILENAME_BODY(body);
+    if(filename && IS_STRING_REP(filename))
+    {
+        s += " (";
+        s += CONST_CSTR_STRING(filename);
+        s += ":";
+        s += std::to_string((long long)(line ? line : GET_STARTLINE_BODY(body)));
+        s += ")";
+    }
+    for(UInt i = 0; i < s.size(); ++i)
+    {
+        if(s[i] == ';')
+            s[i] = ',';
+    }
+    return s;
+}
+
+static Obj FuncGET_SAMPLE_PROFILE_FOLDED(Obj self)
+{
+    // Count identical stacks first, so each stack is only formatted once
+    std::map<std::vector<Int>, UInt> counts;
+    UInt pos = 0;
+    while(pos < sample_buffer.size())
+    {
+        Int depth = sample_buffer[pos];
+        std::vector<Int> key(sample_buffer.begin() + pos + 1,
+                             sample_buffer.begin() + pos + 2 + depth);
+        counts[key]++;
+        pos += depth + 2;
+    }
+
+    std::string out;
+    for(std::map<std::vector<Int>, UInt>::const_iterator it = counts.begin();
+        it != counts.end(); ++it)
+    {
+        const std::vector<Int>& key = it->first;
+        // key is the line, then the functions innermost first
+        for(UInt i = key.size() - 1; i >= 1; --i)
+        {
+            out += describeFrame(sampled_functions.function(key[i]),
+                                 i == 1 ? key[0] : 0);
+            out += (i == 1) ? " " : ";";
+        }
+        out += std::to_string((unsigned long long)it->second);
+        out += "\n";
+    }
+    return MakeString(out.c_str());
+}
+
+static Obj FuncGET_SAMPLE_PROFILE_DROPPED(Obj self)
+{
+    return ObjInt_UInt(dropped_samples);
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(START_SAMPLE_PROFILE, 1, "interval"),
+    GVAR_FUNC(STOP_SAMPLE_PROFILE, 0, ""),
+    GVAR_FUNC(CLEAR_SAMPLE_PROFILE, 0, ""),
+    GVAR_FUNC(GET_SAMPLE_PROFILE_FOLDED, 0, ""),
+    GVAR_FUNC(GET_SAMPLE_PROFILE_DROPPED, 0, ""),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelSampleProfile()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    InitGlobalBag(&sampled_functions.functions, "src/sampling.cc:sampled_functions");
+    return 0;
+}
+
+Int InitLibrarySampleProfile()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    sampled_functions.init();
+    return 0;
+}
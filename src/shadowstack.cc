@@ -0,0 +1,261 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * A native copy of GAP's call stack, so we can say where we are without
+ * walking GAP's frames or calling any GAP code. Each frame records the
+ * function, when it was entered and the line it was called from.
+ *
+ * When GAP jumps out of functions after an error, the functions left are
+ * not reported to our hooks. The throw observer marks the stack as stale,
+ * and before it is next used we drop every frame whose local variables
+ * are no longer on GAP's stack.
+ */
+
+#include "debugger.h"
+#include "function_table.hpp"
+#include "timer.hpp"
+
+#include <algorithm>
+#include <vector>
+
+bool shadow_stack_active;
+
+struct ShadowFrame
+{
+    Int function;
+    // The local variables bag of the call, to check the frame is still
+    // running after an error
+    Obj lvars;
+    uint64_t ticks;
+    // Where the function was called from
+    Int call_file;
+    Int call_line;
+};
+
+static FunctionTable shadow_functions;
+
+static std::vector<ShadowFrame> shadow_stack;
+
+// The line currently running in the innermost frame
+static Int shadow_file;
+static Int shadow_line;
+
+static bool shadow_stale;
+
+// For each function, the number of calls currently running, and the
+// largest number there have been
+static std::vector<Int> shadow_depth;
+static std::vector<Int> shadow_max_depth;
+
+// The stack when a breakpoint last fired
+static std::vector<ShadowFrame> captured_stack;
+static Int captured_file;
+static Int captured_line;
+static bool have_captured_stack;
+
+static TickCalibration shadow_calibration;
+
+static void popShadowFrame()
+{
+    shadow_depth[shadow_stack.back().function]--;
+    shadow_file = shadow_stack.back().call_file;
+    shadow_line = shadow_stack.back().call_line;
+    shadow_stack.pop_back();
+}
+
+// Drop frames GAP jumped out of
+static void resyncShadowStack()
+{
+    shadow_stale = false;
+    std::vector<Obj> live;
+    Obj lvars = STATE(CurrLVars);
+    while(!IsBottomLVars(lvars))
+    {
+        live.push_back(lvars);
+        lvars = PARENT_LVARS(lvars);
+    }
+    std::sort(live.begin(), live.end());
+    while(!shadow_stack.empty() &&
+          !std::binary_search(live.begin(), live.end(), shadow_stack.back().lvars))
+        popShadowFrame();
+    // We do not know which line is running
+    shadow_file = 0;
+    shadow_line = 0;
+}
+
+void shadowStackVisitStat(Int file, Int line)
+{
+    if(shadow_stale)
+        resyncShadowStack();
+    shadow_file = file;
+    shadow_line = line;
+}
+
+void shadowStackEnter(Obj func)
+{
+    if(shadow_stale)
+        resyncShadowStack();
+    Int pos = shadow_functions.lookup(func);
+    if((UInt)pos >= shadow_depth.size())
+    {
+        shadow_depth.resize(pos + 1, 0);
+        shadow_max_depth.resize(pos + 1, 0);
+    }
+    ShadowFrame frame = { pos, STATE(CurrLVars), readTicks(), shadow_file, shadow_line };
+    shadow_stack.push_back(frame);
+    if(++shadow_depth[pos] > shadow_max_depth[pos])
+        shadow_max_depth[pos] = shadow_depth[pos];
+    shadow_file = 0;
+    shadow_line = 0;
+}
+
+void shadowStackLeave(Obj func)
+{
+    if(shadow_stale)
+        resyncShadowStack();
+    Int pos = shadow_functions.lookup(func);
+    // If we started part way through a function, we never saw it entered
+    UInt depth = shadow_stack.size();
+    while(depth > 0 && shadow_stack[depth - 1].function != pos)
+        depth--;
+    if(depth == 0)
+        return;
+    while(shadow_stack.size() >= depth)
+        popShadowFrame();
+}
+
+void shadowStackReset()
+{
+    if(shadow_stack_active)
+        shadow_stale = true;
+}
+
+void shadowStackCapture()
+{
+    if(shadow_stale)
+        resyncShadowStack();
+    captured_stack = shadow_stack;
+    captured_file = shadow_file;
+    captured_line = shadow_line;
+    have_captured_stack = true;
+}
+
+Obj shadowStackFunctions()
+{
+    if(shadow_stale)
+        resyncShadowStack();
+    Obj list = NEW_PLIST(T_PLIST, shadow_stack.size());
+    for(UInt i = shadow_stack.size(); i > 0; --i)
+        PushPlist(list, shadow_functions.function(shadow_stack[i - 1].function));
+    return list;
+}
+
+static Obj filenameOrFail(Int file)
+{
+    return file ? GetCachedFilename(file) : Fail;
+}
+
+// A list of records describing 'stack', innermost first, where the
+// innermost frame is running 'file:line'
+static Obj backtraceToGAP(const std::vector<ShadowFrame>& stack, Int file, Int line)
+{
+    double scale = shadow_calibration.nanosPerTick();
+    uint64_t now = readTicks();
+    Obj list = NEW_PLIST(T_PLIST, stack.size());
+    for(UInt i = stack.size(); i > 0; --i)
+    {
+        const ShadowFrame& frame = stack[i - 1];
+        Obj rec = NEW_PREC(4);
+        AssPRec(rec, RNamName("func"), shadow_functions.function(frame.function));
+        AssPRec(rec, RNamName("file"), filenameOrFail(file));
+        AssPRec(rec, RNamName("line"), INTOBJ_INT(line));
+        AssPRec(rec, RNamName("time"), ObjInt_UInt8((UInt8)((now - frame.ticks) * scale)));
+        PushPlist(list, rec);
+        file = frame.call_file;
+        line = frame.call_line;
+    }
+    return list;
+}
+
+static Obj FuncSTART_SHADOW_STACK(Obj self)
+{
+    if(!shadow_stack_active)
+    {
+        shadow_stack.clear();
+        shadow_depth.clear();
+        shadow_max_depth.clear();
+        shadow_functions.clear();
+        have_captured_stack = false;
+        shadow_calibration.reset();
+        shadow_file = 0;
+        shadow_line = 0;
+        shadow_stale = false;
+    }
+    shadow_stack_active = true;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncSTOP_SHADOW_STACK(Obj self)
+{
+    shadow_stack_active = false;
+    shadow_stack.clear();
+    std::fill(shadow_depth.begin(), shadow_depth.end(), 0);
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncSHADOW_BACKTRACE(Obj self)
+{
+    if(!shadow_stack_active)
+        return Fail;
+    if(shadow_stale)
+        resyncShadowStack();
+    return backtraceToGAP(shadow_stack, shadow_file, shadow_line);
+}
+
+static Obj FuncLAST_BREAKPOINT_BACKTRACE(Obj self)
+{
+    if(!have_captured_stack)
+        return Fail;
+    return backtraceToGAP(captured_stack, captured_file, captured_line);
+}
+
+static Obj FuncRECURSION_DEPTHS(Obj self)
+{
+    Obj list = NEW_PLIST(T_PLIST, 0);
+    for(UInt i = 0; i < shadow_max_depth.size(); ++i)
+    {
+        if(shadow_max_depth[i] == 0)
+            continue;
+        Obj rec = NEW_PREC(2);
+        AssPRec(rec, RNamName("func"), shadow_functions.function(i));
+        AssPRec(rec, RNamName("depth"), INTOBJ_INT(shadow_max_depth[i]));
+        PushPlist(list, rec);
+    }
+    return list;
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(START_SHADOW_STACK, 0, ""),
+    GVAR_FUNC(STOP_SHADOW_STACK, 0, ""),
+    GVAR_FUNC(SHADOW_BACKTRACE, 0, ""),
+    GVAR_FUNC(LAST_BREAKPOINT_BACKTRACE, 0, ""),
+    GVAR_FUNC(RECURSION_DEPTHS, 0, ""),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelShadowStack()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    InitGlobalBag(&shadow_functions.functions, "src/shadowstack.cc:shadow_functions");
+    return 0;
+}
+
+Int InitLibraryShadowStack()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    shadow_functions.init();
+    return 0;
+}
@@ -0,0 +1,429 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * Line and function counters kept in a memory mapped file, so several GAP
+ * processes can add into one profile. Counters are found in a hash table
+ * with open addressing, keyed by the full path of the file rather than
+ * GAP's file ids, which differ between processes. Slots are claimed with
+ * a compare-and-swap and counters updated with atomic adds, so no locks
+ * are needed once the file is set up.
+ */
+
+#include "debugger.h"
+#include "function_table.hpp"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+bool shared_profile_active;
+
+#define SHARED_MAGIC "GAPSHP01"
+#define SHARED_SLOTS (1 << 20)
+#define SHARED_STRING_BYTES (1 << 24)
+
+enum SharedKind { SharedFile = 1, SharedLine = 2, SharedFunction = 3 };
+
+struct SharedHeader
+{
+    char magic[8];
+    uint64_t slots;
+    uint64_t string_bytes;
+    // Bytes of the string area in use
+    uint64_t strings_used;
+    // Counts which could not be recorded, as the table or strings were full
+    uint64_t dropped;
+};
+
+// A counter. 'key' is claimed first, and 'kind' is written last, so
+// readers skip slots which are still being filled in.
+struct SharedSlot
+{
+    uint64_t key;
+    // Hash of the file's path
+    uint64_t file;
+    uint32_t line;
+    uint32_t kind;
+    uint64_t count;
+    // For files and functions, one more than the offset of the name in
+    // the string area
+    uint64_t name;
+};
+
+// A mapped profile file
+struct SharedMapping
+{
+    void* base;
+    size_t size;
+
+    SharedMapping() : base(0), size(0)
+    { }
+
+    SharedHeader* header() const
+    { return (SharedHeader*)base; }
+
+    SharedSlot* slots() const
+    { return (SharedSlot*)((char*)base + sizeof(SharedHeader)); }
+
+    char* strings() const
+    { return (char*)(slots() + header()->slots); }
+
+    void unmap()
+    {
+        if(base)
+            munmap(base, size);
+        base = 0;
+        size = 0;
+    }
+};
+
+static SharedMapping shared_profile;
+
+static inline size_t sharedFileSize(uint64_t slots, uint64_t string_bytes)
+{ return sizeof(SharedHeader) + slots * sizeof(SharedSlot) + string_bytes; }
+
+// For each file id, the hash of its path (or 0 if not yet known), and the
+// counters of each of its lines, found as they are first run
+static std::vector<uint64_t> shared_file_hashes;
+static std::vector<std::vector<uint64_t*> > shared_line_counters;
+
+static FunctionTable shared_functions;
+static std::vector<uint64_t*> shared_function_counters;
+
+static uint64_t hashString(const char* s)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for(; *s; ++s)
+    {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t slotKey(uint64_t file, uint32_t line, uint32_t kind)
+{
+    uint64_t h = file ^ (((uint64_t)line << 8) | kind);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h ? h : 1;
+}
+
+// Copy 'name' into the string area, returning one more than its offset,
+// or 0 if the area is full
+static uint64_t addSharedString(const char* name)
+{
+    SharedHeader* header = shared_profile.header();
+    uint64_t len = strlen(name) + 1;
+    uint64_t offset = __atomic_fetch_add(&header->strings_used, len, __ATOMIC_RELAXED);
+    if(offset + len > header->string_bytes)
+        return 0;
+    memcpy(shared_profile.strings() + offset, name, len);
+    return offset + 1;
+}
+
+// Find the slot for (file, line, kind), claiming it if it is new. 'name'
+// is recorded by the process which claims the slot.
+static SharedSlot* findSharedSlot(uint64_t file, uint32_t line,
+                                  uint32_t kind, const char* name)
+{
+    SharedHeader* header = shared_profile.header();
+    SharedSlot* slots = shared_profile.slots();
+    uint64_t key = slotKey(file, line, kind);
+    for(uint64_t probe = 0; probe < header->slots; ++probe)
+    {
+        SharedSlot* slot = &slots[(key + probe) % header->slots];
+        uint64_t expected = 0;
+        if(__atomic_compare_exchange_n(&slot->key, &expected, key, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            slot->file = file;
+            slot->line = line;
+            slot->name = name ? addSharedString(name) : 0;
+            __atomic_store_n(&slot->kind, kind, __ATOMIC_RELEASE);
+            return slot;
+        }
+        if(expected == key)
+            return slot;
+    }
+    __atomic_fetch_add(&header->dropped, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static uint64_t sharedFileHash(Int file)
+{
+    if((UInt)file >= shared_file_hashes.size())
+        shared_file_hashes.resize(file + 1, 0);
+    if(shared_file_hashes[file] == 0)
+    {
+        Obj filename = GetCachedFilename(file);
+        const char* name = "unknown";
+        char path[PATH_MAX];
+        if(filename && IS_STRING_REP(filename))
+        {
+            name = CONST_CSTR_STRING(filename);
+            if(realpath(name, path))
+                name = path;
+        }
+        uint64_t hash = hashString(name);
+        findSharedSlot(hash, 0, SharedFile, name);
+        shared_file_hashes[file] = hash;
+    }
+    return shared_file_hashes[file];
+}
+
+static inline void sharedIncrement(uint64_t* counter)
+{
+    if(counter)
+        __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+static uint64_t* sharedCounter(SharedSlot* slot)
+{ return slot ? &slot->count : 0; }
+
+// A placeholder for counters we could not allocate, so we do not keep
+// searching for them
+static uint64_t shared_discard;
+
+void sharedProfileVisitStat(Int file, Int line)
+{
+    if((UInt)file >= shared_line_counters.size())
+        shared_line_counters.resize(file + 1);
+    std::vector<uint64_t*>& counters = shared_line_counters[file];
+    if((UInt)line >= counters.size())
+        counters.resize(line + 1, 0);
+    if(!counters[line])
+    {
+        uint64_t* counter = sharedCounter(
+            findSharedSlot(sharedFileHash(file), line, SharedLine, 0));
+        counters[line] = counter ? counter : &shared_discard;
+    }
+    sharedIncrement(counters[line]);
+}
+
+void sharedProfileEnter(Obj func)
+{
+    Int pos = shared_functions.lookup(func);
+    if((UInt)pos >= shared_function_counters.size())
+        shared_function_counters.resize(pos + 1, 0);
+    if(!shared_function_counters[pos])
+    {
+        Obj body = BODY_FUNC(func);
+        Int file = GET_GAPNAMEID_BODY(body);
+        uint64_t* counter = 0;
+        if(file != 0)
+        {
+            Obj name = NAME_FUNC(func);
+            counter = sharedCounter(findSharedSlot(
+                sharedFileHash(file), GET_STARTLINE_BODY(body), SharedFunction,
+                name && IS_STRING_REP(name) ? CONST_CSTR_STRING(name) : "unknown"));
+        }
+        shared_function_counters[pos] = counter ? counter : &shared_discard;
+    }
+    sharedIncrement(shared_function_counters[pos]);
+}
+
+// Map 'filename', creating it if 'create' is true. Returns an error
+// message, or 0 on success.
+static const char* mapSharedProfile(SharedMapping& mapping, const char* filename,
+                                    bool create)
+{
+    int fd = open(filename, create ? O_RDWR | O_CREAT : O_RDONLY, 0666);
+    if(fd < 0)
+        return "Unable to open '%s'";
+    // Only one process sets up a new file
+    flock(fd, LOCK_EX);
+    struct stat st;
+    fstat(fd, &st);
+    size_t size = st.st_size;
+    if(size == 0 && create)
+    {
+        size = sharedFileSize(SHARED_SLOTS, SHARED_STRING_BYTES);
+        SharedHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SHARED_MAGIC, 8);
+        header.slots = SHARED_SLOTS;
+        header.string_bytes = SHARED_STRING_BYTES;
+        if(ftruncate(fd, size) != 0 ||
+           pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+        {
+            flock(fd, LOCK_UN);
+            close(fd);
+            return "Unable to create '%s'";
+        }
+    }
+    flock(fd, LOCK_UN);
+
+    SharedHeader header;
+    if(size < sizeof(header) ||
+       pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+       memcmp(header.magic, SHARED_MAGIC, 8) != 0 ||
+       size != sharedFileSize(header.slots, header.string_bytes))
+    {
+        close(fd);
+        return "'%s' is not a shared profile";
+    }
+    void* base = mmap(0, size, create ? PROT_READ | PROT_WRITE : PROT_READ,
+                      MAP_SHARED, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED)
+        return "Unable to map '%s'";
+    mapping.base = base;
+    mapping.size = size;
+    return 0;
+}
+
+static void resetSharedCounters()
+{
+    shared_file_hashes.clear();
+    shared_line_counters.clear();
+    shared_function_counters.clear();
+    shared_functions.clear();
+}
+
+static Obj FuncSTOP_SHARED_PROFILE(Obj self);
+
+static Obj FuncSTART_SHARED_PROFILE(Obj self, Obj filename)
+{
+    if(!IS_STRING_REP(filename))
+    {
+        ErrorMayQuit("Usage: StartSharedProfile(filename)",0,0);
+    }
+    FuncSTOP_SHARED_PROFILE(0);
+    const char* error = mapSharedProfile(shared_profile, CONST_CSTR_STRING(filename), true);
+    if(error)
+    {
+        ErrorMayQuit(error, (Int)CONST_CSTR_STRING(filename), 0);
+    }
+    shared_profile_active = true;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncSTOP_SHARED_PROFILE(Obj self)
+{
+    shared_profile_active = false;
+    ConsiderEnableDisableDebugging();
+    // The counters point into the mapping, so must be forgotten
+    resetSharedCounters();
+    shared_profile.unmap();
+    return 0;
+}
+
+// Unmaps the file read by READ_SHARED_PROFILE, even if making the result
+// runs out of memory
+static SharedMapping read_mapping;
+
+static Obj FuncREAD_SHARED_PROFILE(Obj self, Obj filename)
+{
+    if(!IS_STRING_REP(filename))
+    {
+        ErrorMayQuit("Usage: ReadSharedProfile(filename)",0,0);
+    }
+    read_mapping.unmap();
+    const char* error = mapSharedProfile(read_mapping, CONST_CSTR_STRING(filename), false);
+    if(error)
+    {
+        ErrorMayQuit(error, (Int)CONST_CSTR_STRING(filename), 0);
+    }
+
+    SharedHeader* header = read_mapping.header();
+    SharedSlot* slots = read_mapping.slots();
+    const char* strings = read_mapping.strings();
+    uint64_t strings_used = __atomic_load_n(&header->strings_used, __ATOMIC_ACQUIRE);
+
+    // Names of files, by hash
+    std::vector<std::pair<uint64_t, std::string> > files;
+    for(uint64_t i = 0; i < header->slots; ++i)
+    {
+        if(__atomic_load_n(&slots[i].kind, __ATOMIC_ACQUIRE) != SharedFile)
+            continue;
+        uint64_t name = slots[i].name;
+        if(name != 0 && name <= strings_used && name <= header->string_bytes)
+            files.push_back(std::make_pair(slots[i].file, std::string(strings + name - 1)));
+    }
+    std::sort(files.begin(), files.end());
+
+    Obj linefiles = NEW_PLIST(T_PLIST, 0);
+    Obj lines = NEW_PLIST(T_PLIST, 0);
+    Obj hits = NEW_PLIST(T_PLIST, 0);
+    Obj functions = NEW_PLIST(T_PLIST, 0);
+    for(uint64_t i = 0; i < header->slots; ++i)
+    {
+        uint32_t kind = __atomic_load_n(&slots[i].kind, __ATOMIC_ACQUIRE);
+        if(kind != SharedLine && kind != SharedFunction)
+            continue;
+        std::vector<std::pair<uint64_t, std::string> >::const_iterator it =
+            std::lower_bound(files.begin(), files.end(),
+                             std::make_pair(slots[i].file, std::string()));
+        if(it == files.end() || it->first != slots[i].file)
+            continue;
+        Obj file = MakeImmString(it->second.c_str());
+        Obj count = ObjInt_UInt8(__atomic_load_n(&slots[i].count, __ATOMIC_RELAXED));
+        if(kind == SharedLine)
+        {
+            PushPlist(linefiles, file);
+            PushPlist(lines, INTOBJ_INT(slots[i].line));
+            PushPlist(hits, count);
+        }
+        else
+        {
+            uint64_t name = slots[i].name;
+            Obj rec = NEW_PREC(4);
+            AssPRec(rec, RNamName("name"), MakeImmString(
+                name != 0 && name <= strings_used && name <= header->string_bytes
+                ? strings + name - 1 : "unknown"));
+            AssPRec(rec, RNamName("file"), file);
+            AssPRec(rec, RNamName("line"), INTOBJ_INT(slots[i].line));
+            AssPRec(rec, RNamName("calls"), count);
+            PushPlist(functions, rec);
+        }
+    }
+    Obj dropped = ObjInt_UInt8(__atomic_load_n(&header->dropped, __ATOMIC_RELAXED));
+    read_mapping.unmap();
+
+    Obj linerec = NEW_PREC(3);
+    AssPRec(linerec, RNamName("file"), linefiles);
+    AssPRec(linerec, RNamName("line"), lines);
+    AssPRec(linerec, RNamName("hits"), hits);
+    Obj result = NEW_PREC(3);
+    AssPRec(result, RNamName("lines"), linerec);
+    AssPRec(result, RNamName("functions"), functions);
+    AssPRec(result, RNamName("dropped"), dropped);
+    return result;
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(START_SHARED_PROFILE, 1, "filename"),
+    GVAR_FUNC(STOP_SHARED_PROFILE, 0, ""),
+    GVAR_FUNC(READ_SHARED_PROFILE, 1, "filename"),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelSharedProfile()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    InitGlobalBag(&shared_functions.functions, "src/sharedprofile.cc:shared_functions");
+    return 0;
+}
+
+Int InitLibrarySharedProfile()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    shared_functions.init();
+    return 0;
+}
@@ -0,0 +1,58 @@
+#ifndef TIMER_HPP_ZNCVBE
+#define TIMER_HPP_ZNCVBE
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Wall-clock time in nanoseconds, from an arbitrary starting point.
+inline uint64_t nanoTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// The cheapest available counter. On x86 this reads the time stamp counter,
+// which only costs a few cycles, elsewhere we fall back to nanoTime.
+// Ticks are converted to nanoseconds with a TickCalibration.
+inline uint64_t readTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return nanoTime();
+#endif
+}
+
+// Records when a measurement started, in both ticks and nanoseconds, so
+// later on ticks can be converted to nanoseconds by comparing how much
+// both clocks have moved.
+class TickCalibration
+{
+    uint64_t start_ticks;
+    uint64_t start_nanos;
+public:
+    TickCalibration()
+    { reset(); }
+
+    void reset()
+    {
+        start_ticks = readTicks();
+        start_nanos = nanoTime();
+    }
+
+    double nanosPerTick() const
+    {
+        uint64_t ticks = readTicks() - start_ticks;
+        uint64_t nanos = nanoTime() - start_nanos;
+        if(ticks == 0)
+            return 1;
+        return (double)nanos / (double)ticks;
+    }
+};
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef TRACE_FORMAT_HPP_UQPLCE
+#define TRACE_FORMAT_HPP_UQPLCE
+
+// The binary format of trace files written by StartTraceFile.
+// This file does not depend on GAP, so it can be used by standalone tools.
+//
+// A trace file starts with the 8 bytes of TRACE_MAGIC, followed by a
+// sequence of records. Each record is a tag byte followed by unsigned
+// LEB128 varints:
+//
+//   TraceFilename  id, length, <length bytes of filename>
+//   TraceFile      file id     (the file of following TraceLine records)
+//   TraceLine      zigzag(line - previous line), time - previous time
+//   TraceEnter     file id, line, time - previous time
+//   TraceLeave     file id, line, time - previous time
+//
+// Times are in nanoseconds. The 'previous' line and time are those of the
+// last record which has a line or time, and both start at 0. A file id is
+// always given a filename before it is used.
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define TRACE_MAGIC "GAPTRC01"
+#define TRACE_MAGIC_LEN 8
+
+enum TraceTag
+{
+    TraceFilename = 1,
+    TraceFile = 2,
+    TraceLine = 3,
+    TraceEnter = 4,
+    TraceLeave = 5
+};
+
+class TraceEncoder
+{
+    int64_t prev_line;
+    uint64_t prev_time;
+
+    void putVarint(std::vector<unsigned char>& out, uint64_t v)
+    {
+        while(v >= 0x80)
+        {
+            out.push_back((unsigned char)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((unsigned char)v);
+    }
+
+    uint64_t timeDelta(uint64_t time)
+    {
+        // Protect against clocks going backwards
+        uint64_t delta = time > prev_time ? time - prev_time : 0;
+        prev_time += delta;
+        return delta;
+    }
+
+public:
+    TraceEncoder() : prev_line(0), prev_time(0)
+    { }
+
+    void reset(uint64_t start_time)
+    {
+        prev_line = 0;
+        prev_time = start_time;
+    }
+
+    void header(std::vector<unsigned char>& out)
+    { out.insert(out.end(), TRACE_MAGIC, TRACE_MAGIC + TRACE_MAGIC_LEN); }
+
+    void filename(std::vector<unsigned char>& out, uint64_t id, const char* name)
+    {
+        size_t len = strlen(name);
+        out.push_back(TraceFilename);
+        putVarint(out, id);
+        putVarint(out, len);
+        out.insert(out.end(), name, name + len);
+    }
+
+    void file(std::vector<unsigned char>& out, uint64_t id)
+    {
+        out.push_back(TraceFile);
+        putVarint(out, id);
+    }
+
+    void line(std::vector<unsigned char>& out, int64_t line, uint64_t time)
+    {
+        int64_t delta = line - prev_line;
+        prev_line = line;
+        out.push_back(TraceLine);
+        putVarint(out, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+        putVarint(out, timeDelta(time));
+    }
+
+    void function(std::vector<unsigned char>& out, TraceTag tag,
+                  uint64_t file, int64_t line, uint64_t time)
+    {
+        out.push_back(tag);
+        putVarint(out, file);
+        putVarint(out, line);
+        prev_line = line;
+        putVarint(out, timeDelta(time));
+    }
+};
+
+struct TraceRecord
+{
+    TraceTag tag;
+    uint64_t file;
+    int64_t line;
+    uint64_t time;
+    // Only set for TraceFilename records
+    std::string filename;
+};
+
+// Reads records from a trace held in memory (usually a mapped file).
+// The decoder's state can be saved and restored with 'position' and
+// 'restore', so a trace can be read in pieces.
+class TraceDecoder
+{
+    const unsigned char* begin;
+    const unsigned char* end;
+    const unsigned char* pos;
+    uint64_t cur_file;
+    int64_t cur_line;
+    uint64_t cur_time;
+    bool failed;
+
+    uint64_t getVarint()
+    {
+        uint64_t v = 0;
+        int shift = 0;
+        while(pos < end && shift < 64)
+        {
+            unsigned char c = *pos++;
+            v |= (uint64_t)(c & 0x7f) << shift;
+            if(!(c & 0x80))
+                return v;
+            shift += 7;
+        }
+        failed = true;
+        return 0;
+    }
+
+public:
+    TraceDecoder(const unsigned char* b, const unsigned char* e)
+    : begin(b), end(e), pos(b), cur_file(0), cur_line(0), cur_time(0),
+      failed(false)
+    { }
+
+    // Check the file starts with the magic bytes, and skip them
+    bool readHeader()
+    {
+        if(end - pos < TRACE_MAGIC_LEN ||
+           memcmp(pos, TRACE_MAGIC, TRACE_MAGIC_LEN) != 0)
+            return false;
+        pos += TRACE_MAGIC_LEN;
+        return true;
+    }
+
+    // True if the trace was truncated or corrupt
+    bool error() const
+    { return failed; }
+
+    uint64_t position() const
+    { return pos - begin; }
+
+    uint64_t file() const
+    { return cur_file; }
+
+    int64_t line() const
+    { return cur_line; }
+
+    uint64_t time() const
+    { return cur_time; }
+
+    void restore(uint64_t position, uint64_t file, int64_t line, uint64_t time)
+    {
+        pos = begin + position;
+        if(pos > end)
+            pos = end;
+        cur_file = file;
+        cur_line = line;
+        cur_time = time;
+    }
+
+    // Read the next record, returning false at the end of the trace
+    bool next(TraceRecord& r)
+    {
+        if(pos >= end || failed)
+            return false;
+        r.tag = (TraceTag)*pos++;
+        switch(r.tag)
+        {
+        case TraceFilename:
+        {
+            r.file = getVarint();
+            uint64_t len = getVarint();
+            if(failed || (uint64_t)(end - pos) < len)
+            {
+                failed = true;
+                return false;
+            }
+            r.filename.assign((const char*)pos, len);
+            pos += len;
+            break;
+        }
+        case TraceFile:
+            cur_file = getVarint();
+            r.file = cur_file;
+            break;
+        case TraceLine:
+        {
+            uint64_t z = getVarint();
+            cur_line += (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+            cur_time += getVarint();
+            r.file = cur_file;
+            r.line = cur_line;
+            r.time = cur_time;
+            break;
+        }
+        case TraceEnter:
+        case TraceLeave:
+            r.file = getVarint();
+            cur_line = getVarint();
+            cur_time += getVarint();
+            r.line = cur_line;
+            r.time = cur_time;
+            break;
+        default:
+            failed = true;
+            return false;
+        }
+        return !failed;
+    }
+};
+
+#endif
@@ -0,0 +1,509 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * A trace of statements, function entries and function exits written to
+ * a compact binary file (see trace_format.hpp), for runs too long to keep
+ * a trace in memory. Records are encoded into one buffer while a
+ * background thread writes out the other, so the interpreter only waits
+ * for the disk if it produces events faster than they can be written.
+ */
+
+#include "debugger.h"
+#include "timer.hpp"
+#include "trace_format.hpp"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+bool trace_file_active;
+
+// When the buffer being filled reaches this size, it is handed to the
+// writer thread
+#define TRACE_BUFFER_SIZE (1 << 20)
+
+static FILE* trace_out;
+static TraceEncoder trace_encoder;
+
+// The buffer the interpreter is filling, and the buffer the writer thread
+// is writing. 'write_pending' is true from when a buffer is handed over
+// until it has been written, and is protected by 'writer_mutex'.
+static std::vector<unsigned char> fill_buffer;
+static std::vector<unsigned char> write_buffer;
+static bool write_pending;
+static bool writer_stopping;
+static bool write_failed;
+static std::mutex writer_mutex;
+static std::condition_variable writer_cv;
+static std::thread writer_thread;
+
+static uint64_t bytes_written;
+
+// File ids which have had their filename written to the trace
+static std::vector<bool> trace_known_files;
+
+// The last statement and file recorded
+static Int trace_prev_file;
+static Int trace_prev_line;
+static Int trace_current_file;
+
+static void writerLoop()
+{
+    std::unique_lock<std::mutex> lock(writer_mutex);
+    for(;;)
+    {
+        writer_cv.wait(lock, []{ return write_pending || writer_stopping; });
+        if(!write_pending)
+            break;
+        lock.unlock();
+        if(fwrite(write_buffer.data(), 1, write_buffer.size(), trace_out)
+           != write_buffer.size())
+            write_failed = true;
+        lock.lock();
+        bytes_written += write_buffer.size();
+        write_buffer.clear();
+        write_pending = false;
+        writer_cv.notify_all();
+    }
+}
+
+// Give the filled buffer to the writer thread, waiting for it to finish
+// the previous buffer if it is still busy.
+static void handOffBuffer()
+{
+    std::unique_lock<std::mutex> lock(writer_mutex);
+    writer_cv.wait(lock, []{ return !write_pending; });
+    fill_buffer.swap(write_buffer);
+    write_pending = true;
+    writer_cv.notify_all();
+}
+
+static void noteFile(Int file)
+{
+    if((UInt)file >= trace_known_files.size())
+        trace_known_files.resize(file + 1);
+    if(!trace_known_files[file])
+    {
+        Obj name = GetCachedFilename(file);
+        trace_encoder.filename(fill_buffer, file,
+                               (name && IS_STRING_REP(name)) ? CONST_CSTR_STRING(name) : "");
+        trace_known_files[file] = true;
+    }
+}
+
+void traceFileVisitStat(Int file, Int line)
+{
+    if(file == trace_prev_file && line == trace_prev_line)
+        return;
+    trace_prev_file = file;
+    trace_prev_line = line;
+    if(file != trace_current_file)
+    {
+        noteFile(file);
+        trace_encoder.file(fill_buffer, file);
+        trace_current_file = file;
+    }
+    trace_encoder.line(fill_buffer, line, nanoTime());
+    if(fill_buffer.size() >= TRACE_BUFFER_SIZE)
+        handOffBuffer();
+}
+
+static void traceFunction(TraceTag tag, Obj func)
+{
+    Obj body = BODY_FUNC(func);
+    Int file = GET_GAPNAMEID_BODY(body);
+    noteFile(file);
+    trace_encoder.function(fill_buffer, tag, file, GET_STARTLINE_BODY(body),
+                           nanoTime());
+    trace_prev_file = 0;
+    if(fill_buffer.size() >= TRACE_BUFFER_SIZE)
+        handOffBuffer();
+}
+
+void traceFileEnter(Obj func)
+{ traceFunction(TraceEnter, func); }
+
+void traceFileLeave(Obj func)
+{ traceFunction(TraceLeave, func); }
+
+static Obj FuncSTART_TRACE_FILE(Obj self, Obj filename)
+{
+    if(!IS_STRING_REP(filename))
+    {
+        ErrorMayQuit("Usage: StartTraceFile(filename)",0,0);
+    }
+    if(trace_file_active)
+    {
+        ErrorMayQuit("A trace file is already being written",0,0);
+    }
+    trace_out = fopen(CONST_CSTR_STRING(filename), "wb");
+    if(!trace_out)
+    {
+        ErrorMayQuit("Unable to open trace file '%s'",
+                     (Int)CONST_CSTR_STRING(filename),0);
+    }
+
+    fill_buffer.clear();
+    fill_buffer.reserve(TRACE_BUFFER_SIZE + 4096);
+    write_buffer.clear();
+    write_buffer.reserve(TRACE_BUFFER_SIZE + 4096);
+    write_pending = false;
+    writer_stopping = false;
+    write_failed = false;
+    bytes_written = 0;
+    trace_prev_file = 0;
+    trace_current_file = 0;
+    trace_encoder.reset(nanoTime());
+
+    // The header: the magic bytes, then every filename GAP knows so far
+    trace_encoder.header(fill_buffer);
+    trace_known_files.clear();
+    Obj cache = CALL_0ARGS(VAL_GVAR(GVarName("GET_FILENAME_CACHE")));
+    for(Int i = 1; i <= LEN_LIST(cache); ++i)
+    {
+        Obj name = ELM0_LIST(cache, i);
+        if(name && IS_STRING_REP(name))
+        {
+            trace_encoder.filename(fill_buffer, i, CONST_CSTR_STRING(name));
+            trace_known_files.resize(i + 1);
+            trace_known_files[i] = true;
+        }
+    }
+
+    // The writer thread must not take GAP's signals, so block them while
+    // it is created, so it inherits a mask blocking everything.
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    writer_thread = std::thread(writerLoop);
+    pthread_sigmask(SIG_SETMASK, &old, 0);
+
+    trace_file_active = true;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+// Write out everything and stop the writer thread. Returns false if
+// writing failed.
+static bool finishTraceFile()
+{
+    handOffBuffer();
+    {
+        std::unique_lock<std::mutex> lock(writer_mutex);
+        writer_stopping = true;
+        writer_cv.notify_all();
+    }
+    writer_thread.join();
+    bool failed = write_failed;
+    if(fclose(trace_out) != 0)
+        failed = true;
+    trace_out = 0;
+    std::vector<unsigned char>().swap(fill_buffer);
+    std::vector<unsigned char>().swap(write_buffer);
+    return !failed;
+}
+
+// Stop tracing, write out everything and close the file. Returns the
+// size of the file.
+static Obj FuncSTOP_TRACE_FILE(Obj self)
+{
+    if(!trace_file_active)
+        return Fail;
+    trace_file_active = false;
+    ConsiderEnableDisableDebugging();
+    if(!finishTraceFile())
+    {
+        ErrorMayQuit("Error writing trace file",0,0);
+    }
+    return ObjInt_UInt8(bytes_written);
+}
+
+// If GAP exits while a trace is being written, finish the file. This must
+// happen before writer_thread is destroyed, as destroying a thread which
+// has not been joined terminates the process.
+static void finishTraceFileAtExit()
+{
+    if(!trace_file_active)
+        return;
+    trace_file_active = false;
+    finishTraceFile();
+}
+
+// Line numbers above this are treated as corrupt
+#define TRACE_MAX_LINE 0x7fffffff
+
+// A read-only mapping of a trace file. Each reader has its own, so a
+// callback can read another trace while one is being read.
+struct MappedTrace
+{
+    const unsigned char* data;
+    size_t size;
+
+    MappedTrace() : data(0), size(0)
+    { }
+
+    ~MappedTrace()
+    { close(); }
+
+    void close()
+    {
+        if(data)
+            munmap((void*)data, size);
+        data = 0;
+        size = 0;
+    }
+};
+
+static void mapTraceFile(Obj filename, MappedTrace& trace)
+{
+    if(!IS_STRING_REP(filename))
+    {
+        ErrorMayQuit("Trace filename must be a string",0,0);
+    }
+    int fd = open(CONST_CSTR_STRING(filename), O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0)
+    {
+        if(fd >= 0)
+            ::close(fd);
+        ErrorMayQuit("Unable to open trace file '%s'",
+                     (Int)CONST_CSTR_STRING(filename),0);
+    }
+    void* p = 0;
+    if(st.st_size > 0)
+    {
+        p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED)
+            p = 0;
+    }
+    ::close(fd);
+    if(p)
+    {
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        trace.data = (const unsigned char*)p;
+        trace.size = st.st_size;
+    }
+    TraceDecoder check(trace.data, trace.data + trace.size);
+    if(!check.readHeader())
+    {
+        trace.close();
+        ErrorMayQuit("'%s' is not a trace file",
+                     (Int)CONST_CSTR_STRING(filename),0);
+    }
+}
+
+// The filenames given in TraceFilename records. Ids are read from the
+// file, so they are looked up in a map rather than used as positions.
+class TraceFilenames
+{
+    Obj names;
+    std::unordered_map<uint64_t, Int> positions;
+
+public:
+    TraceFilenames() : names(NEW_PLIST(T_PLIST, 0))
+    { }
+
+    void add(const TraceRecord& r)
+    {
+        PushPlist(names, MakeImmString(r.filename.c_str()));
+        positions[r.file] = LEN_PLIST(names);
+    }
+
+    // The position of the name of file 'id', or 0 if it has no name
+    Int position(uint64_t id) const
+    {
+        std::unordered_map<uint64_t, Int>::const_iterator it = positions.find(id);
+        return it == positions.end() ? 0 : it->second;
+    }
+
+    Obj name(Int pos) const
+    { return ELM_PLIST(names, pos); }
+};
+
+// Events must refer to a named file, and have a line GAP can represent
+static bool validTraceEvent(const TraceFilenames& filenames, const TraceRecord& r)
+{
+    return filenames.position(r.file) != 0 && r.line >= 0 &&
+           r.line <= TRACE_MAX_LINE && r.line <= INT_INTOBJ_MAX;
+}
+
+static EventKind traceEventKind(TraceTag tag)
+{
+    return tag == TraceLine ? EventStatement :
+           tag == TraceEnter ? EventEnter : EventLeave;
+}
+
+// Pass the events of 'trace' to 'func'. Returns false if the trace is
+// truncated or corrupt.
+static bool readTraceEvents(const MappedTrace& trace, Obj func, UInt chunksize)
+{
+    TraceFilenames filenames;
+    TraceDecoder decoder(trace.data, trace.data + trace.size);
+    decoder.readHeader();
+    TraceRecord r;
+    Obj events = NEW_PLIST(T_PLIST, chunksize);
+    bool corrupt = false;
+    while(decoder.next(r))
+    {
+        if(r.tag == TraceFilename)
+        {
+            filenames.add(r);
+            continue;
+        }
+        if(r.tag == TraceFile)
+            continue;
+        if(!validTraceEvent(filenames, r))
+        {
+            corrupt = true;
+            break;
+        }
+        Obj entry = NEW_PLIST(T_PLIST, 4);
+        SET_LEN_PLIST(entry, 4);
+        SET_ELM_PLIST(entry, 1, INTOBJ_INT(traceEventKind(r.tag)));
+        SET_ELM_PLIST(entry, 2, filenames.name(filenames.position(r.file)));
+        SET_ELM_PLIST(entry, 3, INTOBJ_INT(r.line));
+        SET_ELM_PLIST(entry, 4, ObjInt_UInt8(r.time));
+        CHANGED_BAG(entry);
+        PushPlist(events, entry);
+        if((UInt)LEN_PLIST(events) == chunksize)
+        {
+            CALL_1ARGS(func, events);
+            events = NEW_PLIST(T_PLIST, chunksize);
+        }
+    }
+    if(LEN_PLIST(events) > 0)
+        CALL_1ARGS(func, events);
+    return !corrupt && !decoder.error();
+}
+
+// Call 'func' on the events in a trace file, in lists of at most 'chunk'
+// events. Each event is [kind, filename, line, time], as in
+// DrainEventTrace, but with a filename in place of the function.
+static Obj FuncREAD_TRACE_FILE(Obj self, Obj filename, Obj func, Obj chunk)
+{
+    if(!IS_FUNC(func) || !IS_POS_INTOBJ(chunk))
+    {
+        ErrorMayQuit("Usage: ReadTraceFile(filename, func[, chunk])",0,0);
+    }
+    MappedTrace trace;
+    mapTraceFile(filename, trace);
+    bool ok = false;
+    // 'func' may raise an error, which does not run destructors
+    GAP_TRY
+    {
+        ok = readTraceEvents(trace, func, INT_INTOBJ(chunk));
+    }
+    GAP_CATCH
+    {
+        trace.close();
+        GAP_THROW();
+    }
+    trace.close();
+    if(!ok)
+    {
+        ErrorMayQuit("Trace file is truncated or corrupt",0,0);
+    }
+    return 0;
+}
+
+// Summarise a trace file without creating a GAP object per event
+static Obj FuncTRACE_FILE_SUMMARY(Obj self, Obj filename)
+{
+    MappedTrace trace;
+    mapTraceFile(filename, trace);
+    TraceFilenames filenames;
+    TraceDecoder decoder(trace.data, trace.data + trace.size);
+    decoder.readHeader();
+    // Hits of each line, indexed by the position of the file's name and
+    // the line, so corrupt ids and lines cannot make us allocate more
+    // than one entry per record
+    std::unordered_map<uint64_t, uint64_t> hits;
+    uint64_t statements = 0, calls = 0;
+    uint64_t end_time = 0;
+    bool corrupt = false;
+    TraceRecord r;
+    while(!corrupt && decoder.next(r))
+    {
+        if(r.tag == TraceFilename)
+        {
+            filenames.add(r);
+            continue;
+        }
+        if(r.tag == TraceFile)
+            continue;
+        if(!validTraceEvent(filenames, r))
+        {
+            corrupt = true;
+            break;
+        }
+        end_time = r.time;
+        if(r.tag == TraceLine)
+        {
+            hits[((uint64_t)filenames.position(r.file) << 32) | r.line]++;
+            statements++;
+        }
+        else if(r.tag == TraceEnter)
+            calls++;
+    }
+    bool failed = corrupt || decoder.error();
+    trace.close();
+
+    std::vector<std::pair<uint64_t, uint64_t> > sorted(hits.begin(), hits.end());
+    std::sort(sorted.begin(), sorted.end());
+    Obj files = NEW_PLIST(T_PLIST, sorted.size());
+    Obj lines = NEW_PLIST(T_PLIST, sorted.size());
+    Obj counts = NEW_PLIST(T_PLIST, sorted.size());
+    for(UInt i = 0; i < sorted.size(); ++i)
+    {
+        PushPlist(files, filenames.name(sorted[i].first >> 32));
+        PushPlist(lines, INTOBJ_INT(sorted[i].first & 0xffffffff));
+        PushPlist(counts, ObjInt_UInt8(sorted[i].second));
+    }
+    Obj linerec = NEW_PREC(3);
+    AssPRec(linerec, RNamName("file"), files);
+    AssPRec(linerec, RNamName("line"), lines);
+    AssPRec(linerec, RNamName("hits"), counts);
+
+    Obj rec = NEW_PREC(5);
+    AssPRec(rec, RNamName("statements"), ObjInt_UInt8(statements));
+    AssPRec(rec, RNamName("calls"), ObjInt_UInt8(calls));
+    AssPRec(rec, RNamName("duration"), ObjInt_UInt8(end_time));
+    AssPRec(rec, RNamName("lines"), linerec);
+    AssPRec(rec, RNamName("complete"), failed ? False : True);
+    return rec;
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(START_TRACE_FILE, 1, "filename"),
+    GVAR_FUNC(STOP_TRACE_FILE, 0, ""),
+    GVAR_FUNC(READ_TRACE_FILE, 3, "filename, func, chunk"),
+    GVAR_FUNC(TRACE_FILE_SUMMARY, 1, "filename"),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelTraceFile()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    atexit(finishTraceFileAtExit);
+    return 0;
+}
+
+Int InitLibraryTraceFile()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    return 0;
+}
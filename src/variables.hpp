@@ -0,0 +1,63 @@
+#ifndef VARIABLES_HPP_RTQXFO
+#define VARIABLES_HPP_RTQXFO
+
+#include <string>
+#include <string.h>
+
+#include "gap_all.h"   // GAP headers
+
+// A variable, given by name, which is read from the function currently
+// being executed. If the function has a local variable (or argument) with
+// this name we read that, otherwise we read the global variable.
+// Reading returns 0 if the variable is not bound.
+class VariableRef
+{
+    std::string var_name;
+    UInt gvar;
+    // Position of the name in the last function we looked in, which is
+    // usually the right place to look next time.
+    mutable Int local_hint;
+
+    bool isName(Obj names, Int pos) const
+    {
+        Obj name = ELM_PLIST(names, pos);
+        return name && IS_STRING_REP(name) &&
+               strcmp(CONST_CSTR_STRING(name), var_name.c_str()) == 0;
+    }
+
+public:
+    VariableRef() : gvar(0), local_hint(0)
+    { }
+
+    VariableRef(const std::string& name)
+    : var_name(name), gvar(GVarName(name.c_str())), local_hint(0)
+    { }
+
+    const std::string& name() const
+    { return var_name; }
+
+    bool empty() const
+    { return var_name.empty(); }
+
+    Obj read() const
+    {
+        Obj names = NAMS_FUNC(CURR_FUNC());
+        if(names)
+        {
+            Int count = LEN_PLIST(names);
+            if(local_hint > 0 && local_hint <= count && isName(names, local_hint))
+                return OBJ_LVAR(local_hint);
+            for(Int i = 1; i <= count; ++i)
+            {
+                if(isName(names, i))
+                {
+                    local_hint = i;
+                    return OBJ_LVAR(i);
+                }
+            }
+        }
+        return VAL_GVAR(gvar);
+    }
+};
+
+#endif
@@ -0,0 +1,235 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * Watchpoints on global variables. After each statement we compare the
+ * value of every watched variable with the value we last saw, and only
+ * call into GAP when one has changed.
+ */
+
+#include "debugger.h"
+
+#include <vector>
+
+bool watch_active;
+
+// Only this many elements of a list or record, or characters of a string,
+// are included in its fingerprint
+#define WATCH_FINGERPRINT_LIMIT 256
+
+// The watched variables. The name, last value and callback of each are
+// stored in GAP lists, so the GC sees them. Unbound variables are given
+// the value 'watch_unbound', which is never the value of a variable.
+static std::vector<UInt> watch_gvars;
+static std::vector<uint64_t> watch_fingerprints;
+static Obj watch_names;
+static Obj watch_values;
+static Obj watch_callbacks;
+static Obj watch_unbound;
+
+// The statement which ran before the current one, which is where any
+// change we find must have happened
+static Int watch_prev_file;
+static Int watch_prev_line;
+
+static inline uint64_t mixFingerprint(uint64_t h, uint64_t v)
+{
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+// A cheap summary of the contents of plain lists, records and strings, so
+// we notice when they are changed in place. Elements are compared by
+// identity, not value, and only the first WATCH_FINGERPRINT_LIMIT are used.
+static uint64_t fingerprint(Obj val)
+{
+    if(IS_INTOBJ(val) || IS_FFE(val))
+        return 0;
+    uint64_t h = TNUM_OBJ(val);
+    if(IS_PLIST(val))
+    {
+        Int len = LEN_PLIST(val);
+        h = mixFingerprint(h, len);
+        if(len > WATCH_FINGERPRINT_LIMIT)
+            len = WATCH_FINGERPRINT_LIMIT;
+        for(Int i = 1; i <= len; ++i)
+            h = mixFingerprint(h, (uint64_t)ELM_PLIST(val, i));
+    }
+    else if(IS_PREC(val))
+    {
+        Int len = LEN_PREC(val);
+        h = mixFingerprint(h, len);
+        if(len > WATCH_FINGERPRINT_LIMIT)
+            len = WATCH_FINGERPRINT_LIMIT;
+        for(Int i = 1; i <= len; ++i)
+        {
+            h = mixFingerprint(h, GET_RNAM_PREC(val, i));
+            h = mixFingerprint(h, (uint64_t)GET_ELM_PREC(val, i));
+        }
+    }
+    else if(IS_STRING_REP(val))
+    {
+        UInt len = GET_LEN_STRING(val);
+        h = mixFingerprint(h, len);
+        if(len > WATCH_FINGERPRINT_LIMIT)
+            len = WATCH_FINGERPRINT_LIMIT;
+        const char* s = CONST_CSTR_STRING(val);
+        for(UInt i = 0; i < len; ++i)
+            h = mixFingerprint(h, (unsigned char)s[i]);
+    }
+    return h;
+}
+
+static inline Obj watchValue(UInt i)
+{
+    Obj val = VAL_GVAR(watch_gvars[i]);
+    return val ? val : watch_unbound;
+}
+
+static void recordWatchValue(UInt i)
+{
+    Obj val = watchValue(i);
+    SET_ELM_PLIST(watch_values, i + 1, val);
+    CHANGED_BAG(watch_values);
+    watch_fingerprints[i] = fingerprint(val);
+}
+
+static void watchCheck()
+{
+    bool called = false;
+    for(UInt i = 0; i < watch_gvars.size(); ++i)
+    {
+        Obj val = watchValue(i);
+        Obj old = ELM_PLIST(watch_values, i + 1);
+        if(val == old && fingerprint(val) == watch_fingerprints[i])
+            continue;
+        recordWatchValue(i);
+        // 'old' is on the C stack, so is kept alive while the callback runs
+        disable_debugger = 1;
+        CALL_5ARGS(ELM_PLIST(watch_callbacks, i + 1),
+                   ELM_PLIST(watch_names, i + 1),
+                   old == watch_unbound ? Fail : old,
+                   val == watch_unbound ? Fail : val,
+                   INTOBJ_INT(watch_prev_file),
+                   INTOBJ_INT(watch_prev_line));
+        disable_debugger = 0;
+        called = true;
+    }
+    // Do not report changes made by the callbacks themselves
+    if(called)
+    {
+        for(UInt i = 0; i < watch_gvars.size(); ++i)
+            recordWatchValue(i);
+    }
+}
+
+void watchVisitStat(Int file, Int line)
+{
+    watchCheck();
+    watch_prev_file = file;
+    watch_prev_line = line;
+}
+
+void watchLeaveFunction()
+{
+    watchCheck();
+}
+
+static Int findWatch(UInt gvar)
+{
+    for(UInt i = 0; i < watch_gvars.size(); ++i)
+    {
+        if(watch_gvars[i] == gvar)
+            return i;
+    }
+    return -1;
+}
+
+static Obj FuncWATCH_GLOBAL(Obj self, Obj name, Obj callback)
+{
+    if(!IS_STRING_REP(name) || !IS_FUNC(callback))
+    {
+        ErrorMayQuit("Usage: WatchGlobal(name[, callback])",0,0);
+    }
+    UInt gvar = GVarName(CONST_CSTR_STRING(name));
+    Int i = findWatch(gvar);
+    if(i < 0)
+    {
+        i = watch_gvars.size();
+        watch_gvars.push_back(gvar);
+        watch_fingerprints.push_back(0);
+        PushPlist(watch_names, MakeImmString(CONST_CSTR_STRING(name)));
+        PushPlist(watch_callbacks, callback);
+        PushPlist(watch_values, watch_unbound);
+    }
+    else
+    {
+        SET_ELM_PLIST(watch_callbacks, i + 1, callback);
+        CHANGED_BAG(watch_callbacks);
+    }
+    recordWatchValue(i);
+    watch_prev_file = 0;
+    watch_prev_line = 0;
+    watch_active = true;
+    ConsiderEnableDisableDebugging();
+    return 0;
+}
+
+static Obj FuncUNWATCH_GLOBAL(Obj self, Obj name)
+{
+    if(!IS_STRING_REP(name))
+    {
+        ErrorMayQuit("Usage: UnwatchGlobal(name)",0,0);
+    }
+    Int i = findWatch(GVarName(CONST_CSTR_STRING(name)));
+    if(i < 0)
+        return False;
+    Int last = watch_gvars.size() - 1;
+    watch_gvars[i] = watch_gvars[last];
+    watch_fingerprints[i] = watch_fingerprints[last];
+    watch_gvars.pop_back();
+    watch_fingerprints.pop_back();
+    Obj lists[3] = { watch_names, watch_values, watch_callbacks };
+    for(int l = 0; l < 3; ++l)
+    {
+        SET_ELM_PLIST(lists[l], i + 1, ELM_PLIST(lists[l], last + 1));
+        SET_ELM_PLIST(lists[l], last + 1, 0);
+        SET_LEN_PLIST(lists[l], last);
+        CHANGED_BAG(lists[l]);
+    }
+    watch_active = !watch_gvars.empty();
+    ConsiderEnableDisableDebugging();
+    return True;
+}
+
+static Obj FuncWATCHED_GLOBALS(Obj self)
+{
+    return SHALLOW_COPY_OBJ(watch_names);
+}
+
+// Table of functions to export
+static StructGVarFunc GVarFuncs [] = {
+    GVAR_FUNC(WATCH_GLOBAL, 2, "name, callback"),
+    GVAR_FUNC(UNWATCH_GLOBAL, 1, "name"),
+    GVAR_FUNC(WATCHED_GLOBALS, 0, ""),
+    { 0 } /* Finish with an empty entry */
+};
+
+Int InitKernelWatch()
+{
+    InitHdlrFuncsFromTable( GVarFuncs );
+    InitGlobalBag(&watch_names, "src/watch.cc:watch_names");
+    InitGlobalBag(&watch_values, "src/watch.cc:watch_values");
+    InitGlobalBag(&watch_callbacks, "src/watch.cc:watch_callbacks");
+    InitGlobalBag(&watch_unbound, "src/watch.cc:watch_unbound");
+    return 0;
+}
+
+Int InitLibraryWatch()
+{
+    InitGVarFuncsFromTable( GVarFuncs );
+    watch_names = NEW_PLIST(T_PLIST, 0);
+    watch_values = NEW_PLIST(T_PLIST, 0);
+    watch_callbacks = NEW_PLIST(T_PLIST, 0);
+    watch_unbound = NEW_PLIST(T_PLIST, 0);
+    return 0;
+}
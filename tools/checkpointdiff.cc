@@ -0,0 +1,54 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * A standalone tool which compares two checkpoint files written by
+ * StartCheckpointTrace, without needing GAP. If the runs differ it prints
+ * the first window of statements which differs, as
+ *
+ *   from <tab> to
+ *
+ * which can be given to StartCheckpointTrace to trace just that window,
+ * and exits with status 1. If the runs are the same it prints nothing.
+ *
+ * Build with 'make checkpointdiff'.
+ */
+
+#include "../src/checkpoint_format.hpp"
+
+#include <stdio.h>
+
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    if(argc != 3)
+    {
+        fprintf(stderr, "Usage: %s checkpointfile1 checkpointfile2\n", argv[0]);
+        return 2;
+    }
+    CheckpointHeader header[2];
+    std::vector<Checkpoint> points[2];
+    for(int i = 0; i < 2; ++i)
+    {
+        if(!readCheckpointFile(argv[i + 1], header[i], points[i]))
+        {
+            fprintf(stderr, "%s: not a checkpoint file\n", argv[i + 1]);
+            return 2;
+        }
+    }
+    if(header[0].interval != header[1].interval)
+    {
+        fprintf(stderr, "checkpoint files have different intervals\n");
+        return 2;
+    }
+
+    size_t n0 = points[0].size(), n1 = points[1].size();
+    size_t i = firstCheckpointDifference(n0 ? &points[0][0] : 0, n0,
+                                         n1 ? &points[1][0] : 0, n1);
+    if(i == n0 && n0 == n1)
+        return 0;
+    uint64_t from = i == 0 ? 1 : points[0][i - 1].statements + 1;
+    printf("%llu\t%llu\n", (unsigned long long)from,
+           (unsigned long long)(from + header[0].interval - 1));
+    return 1;
+}
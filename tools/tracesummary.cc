@@ -0,0 +1,110 @@
+/*
+ * debugger: Debugging support for GAP
+ *
+ * A standalone tool which summarises a trace file written by
+ * StartTraceFile, without needing GAP. It prints the number of statements
+ * and calls, followed by how often each line was executed, as
+ *
+ *   hits <tab> filename:line
+ *
+ * Build with 'make tracesummary'.
+ */
+
+#include "../src/trace_format.hpp"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    if(argc != 2)
+    {
+        fprintf(stderr, "Usage: %s tracefile\n", argv[0]);
+        return 1;
+    }
+    int fd = open(argv[1], O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    const unsigned char* data = 0;
+    if(st.st_size > 0)
+    {
+        void* p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        data = (const unsigned char*)p;
+    }
+    close(fd);
+
+    TraceDecoder decoder(data, data + st.st_size);
+    if(!decoder.readHeader())
+    {
+        fprintf(stderr, "%s: not a trace file\n", argv[1]);
+        return 1;
+    }
+
+    std::map<uint64_t, std::string> filenames;
+    std::vector<std::vector<uint64_t> > hits;
+    uint64_t statements = 0, calls = 0, end_time = 0;
+    TraceRecord r;
+    while(decoder.next(r))
+    {
+        switch(r.tag)
+        {
+        case TraceFilename:
+            filenames[r.file] = r.filename;
+            break;
+        case TraceLine:
+            if(r.file >= hits.size())
+                hits.resize(r.file + 1);
+            if((uint64_t)r.line >= hits[r.file].size())
+                hits[r.file].resize(r.line + 1);
+            hits[r.file][r.line]++;
+            statements++;
+            end_time = r.time;
+            break;
+        case TraceEnter:
+            calls++;
+            end_time = r.time;
+            break;
+        case TraceLeave:
+            end_time = r.time;
+            break;
+        default:
+            break;
+        }
+    }
+
+    printf("statements: %llu\ncalls: %llu\nduration: %.6fs\n",
+           (unsigned long long)statements, (unsigned long long)calls,
+           end_time / 1e9);
+    for(size_t file = 0; file < hits.size(); ++file)
+    {
+        for(size_t line = 1; line < hits[file].size(); ++line)
+        {
+            if(hits[file][line])
+                printf("%llu\t%s:%zu\n", (unsigned long long)hits[file][line],
+                       filenames[file].c_str(), line);
+        }
+    }
+    if(decoder.error())
+    {
+        fprintf(stderr, "%s: trace is truncated or corrupt\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode5.g");
+gap> ClearAllocationProfile();
+gap> StartAllocationProfile(); alloc(1000);; StopAllocationProfile();
+gap> prof := AllocationProfile();;
+gap> pos := Filtered([1..Length(prof.lines.file)], i -> EndsWith(prof.lines.file[i], "testcode5.g"));;
+gap> prof.lines.line[pos[1]];
+5
+gap> prof.lines.bags[pos[1]] >= 1000;
+true
+gap> IsSortedList(Reversed(prof.lines.bytes));
+true
+gap> ForAny(prof.functions, r -> r.func = alloc and r.bytes > 0);
+true
+gap> Length(AllocationProfile(1).lines.line);
+1
+gap> ClearAllocationProfile();
+gap> AllocationProfile().lines.file;
+[  ]
+gap> AllocationProfile(0);
+Error, Usage: AllocationProfile([n])
@@ -0,0 +1,61 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode1.g");
+gap> pr := l -> function() Print(l, ":", gvar, "\n"); end;;
+gap> AddBreakpoints([["testcode1.g", 5, pr(5)], ["testcode1.g", 6, pr(6)],
+>                    ["testcode1.g", 7, pr(7), rec(ignore := 1)]]);
+gap> f();
+5:mark
+6:mark
+gap> f();
+5:change
+6:change
+7:change
+gap> ClearBreakpoints([["testcode1.g", 5], ["testcode1.g", 6]]);
+2
+gap> f();
+7:change
+gap> ClearBreakpoints([["testcode1.g", 5]]);
+0
+gap> AddBreakpoints([["testcode1.g", 5], ["testcode1.g", 6, pr(6)]]);
+gap> AddBreakpoint("notloadedyet.g", 12, rec(every := 2));
+Adding pending breakpoint to notloadedyet.g:12
+gap> savefile := Filename(DirectoryTemporary(), "breakpoints.txt");;
+gap> SaveBreakpoints(savefile);
+4
+gap> ClearAllBreakpoints();
+gap> ListBreakpoints();
+[  ]
+gap> LoadBreakpoints(savefile, function() Print("loaded\n"); end);
+4
+gap> List(ListBreakpoints(), x -> x[2]);
+[ 7, 5, 6 ]
+gap> ListPendingBreakpoints();
+[ [ "notloadedyet.g", 12 ] ]
+gap> f();
+loaded
+loaded
+gap> f();
+loaded
+loaded
+loaded
+gap> AddBreakpoints([["testcode1.g", 0]]);
+Error, Usage: AddBreakpoints(list), where each entry is [file, line [, func] [, options]]
+gap> ClearAllBreakpoints();
+gap> AddBreakpoints([["notloadedyet.g", 3], ["testcode1.g", 5, rec(every := 0)]]);
+Error, Breakpoint option 'every' must be positive
+gap> ListPendingBreakpoints();
+[  ]
+gap> ListBreakpoints();
+[  ]
+gap> AddBreakpoints([["notloadedyet.g", 3], ["testcode1.g", 5, pr(5)]]);
+gap> ListPendingBreakpoints();
+[ [ "notloadedyet.g", 3 ] ]
+gap> List(ListBreakpoints(), x -> x[2]);
+[ 5 ]
+gap> ClearAllBreakpoints();
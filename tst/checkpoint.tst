@@ -0,0 +1,32 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testif.g");
+gap> dir := DirectoryTemporary();;
+gap> run1 := Filename(dir, "run1.chk");;
+gap> run2 := Filename(dir, "run2.chk");;
+gap> run3 := Filename(dir, "run3.chk");;
+gap> StartCheckpointTrace(run1, 2); f(1); StopCheckpointTrace();
+5
+gap> StopCheckpointTrace();
+fail
+gap> StartCheckpointTrace(run2, 2); f(1); StopCheckpointTrace();
+5
+gap> FirstCheckpointDifference(run1, run2);
+fail
+gap> StartCheckpointTrace(run3, 2); f(0); StopCheckpointTrace();
+4
+gap> window := FirstCheckpointDifference(run1, run3);
+rec( from := 3, to := 4 )
+gap> window.trace := Filename(dir, "window.bin");;
+gap> StartCheckpointTrace(run2, 2, window); f(1); StopCheckpointTrace();
+5
+gap> s := TraceFileSummary(window.trace);;
+gap> [s.statements, s.lines.line];
+[ 2, [ 6, 7 ] ]
+gap> FirstCheckpointDifference(run1, "testif.g");
+Error, 'testif.g' is not a checkpoint file
@@ -0,0 +1,49 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode2.g");
+gap> ClearChromeTrace();
+gap> StartChromeTrace(); f(); StopChromeTrace();
+gap> jsonfile := Filename(DirectoryTemporary(), "trace.json");;
+gap> WriteChromeTrace(jsonfile);
+0
+gap> lines := SplitString(StringFile(jsonfile), "\n");;
+gap> events := Filtered(lines, l -> StartsWith(l, "{\"ph\":\"B\"") or
+>                                   StartsWith(l, "{\"ph\":\"E\""));;
+gap> List(events, l -> l{[8]});
+[ "B", "B", "E", "B", "E", "B", "E", "E" ]
+gap> Number(events, l -> PositionSublist(l, "\"name\"") <> fail);
+0
+gap> Number(events, l -> PositionSublist(l, "\"sf\":") <> fail);
+4
+gap> Number(lines, l -> PositionSublist(l, "{\"name\":\"g\"") <> fail);
+1
+gap> Number(lines, l -> PositionSublist(l, "testcode2.g:") <> fail);
+2
+gap> balanced := function(file)
+>   local events;
+>   events := Filtered(SplitString(StringFile(file), "\n"),
+>                      l -> StartsWith(l, "{\"ph\":\"B\"") or
+>                           StartsWith(l, "{\"ph\":\"E\""));
+>   return Number(events, l -> l{[8]} = "B") = Number(events, l -> l{[8]} = "E");
+> end;;
+gap> boom := function() Error("boom"); end;;
+gap> ClearChromeTrace();
+gap> StartChromeTrace(); boom();
+Error, boom
+gap> f(); StopChromeTrace();
+gap> WriteChromeTrace(jsonfile);
+0
+gap> balanced(jsonfile);
+true
+gap> ClearChromeTrace();
+gap> write := function() g("D"); return WriteChromeTrace(jsonfile); end;;
+gap> StartChromeTrace(); write(); StopChromeTrace();
+0
+gap> balanced(jsonfile);
+true
+gap> ClearChromeTrace();
@@ -24,18 +24,18 @@ gap> ClearBreakpoint("testcode1.g", 6);
 Removing breakpoint from testcode1.g:6
 gap> f();
 5:change
-6:change
+7:change
 gap> ClearBreakpoint("testcode1.g", 6);
 gap> f();
 5:change
-6:change
+7:change
 gap> ClearBreakpoint("testcode1.g", 5);
 Removing breakpoint from testcode1.g:5
 gap> f();
-5:change
+7:change
 gap> ClearBreakpoint("qqqqwwwwnotafilenameg", 5);
 Error, Filename not found
 gap> f();
-5:change
+7:change
 gap> ClearAllBreakpoints();
 gap> f();
@@ -0,0 +1,65 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode3.g");
+gap> pr := function() Print(gcount, "\n"); end;;
+gap> AddBreakpoint("testcode3.g", 7, pr, rec(every := 3));
+Adding breakpoint to testcode3.g:7
+gap> gcount := 0;; loopf(10);
+2
+5
+8
+55
+gap> List(BreakpointHitCounts(), x -> x[3]);
+[ 10 ]
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode3.g", 7, pr, rec(ignore := 7));
+Adding breakpoint to testcode3.g:7
+gap> gcount := 0;; loopf(10);
+7
+8
+9
+55
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode3.g", 7, pr, rec(ignore := 2, every := 4));
+Adding breakpoint to testcode3.g:7
+gap> gcount := 0;; loopf(10);
+5
+9
+55
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode3.g", 7, pr, rec(variable := "i", equals := 4));
+Adding breakpoint to testcode3.g:7
+gap> gcount := 0;; loopf(10);
+3
+55
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode3.g", 7, pr, rec(variable := "i", atLeast := 9));
+Adding breakpoint to testcode3.g:7
+gap> gcount := 0;; loopf(10);
+8
+9
+55
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode3.g", 7, pr, rec(variable := "gcount", equals := 5));
+Adding breakpoint to testcode3.g:7
+gap> gcount := 0;; loopf(10);
+5
+55
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode3.g", 7, pr, rec(variable := "notavariable", equals := 5));
+Adding breakpoint to testcode3.g:7
+gap> gcount := 0;; loopf(10);
+55
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode3.g", 7, pr, rec(every := 0));
+Adding breakpoint to testcode3.g:7
+Error, Breakpoint option 'every' must be positive
+gap> AddBreakpoint("testcode3.g", 7, pr, rec(variable := "i"));
+Adding breakpoint to testcode3.g:7
+Error, Breakpoint option 'variable' needs exactly one of 'equals' or 'atLeast'
+gap> ClearAllBreakpoints();
@@ -0,0 +1,33 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> ClearCoverage();
+gap> StartCoverage();
+gap> Read("testcode1.g");
+gap> f();
+gap> StopCoverage();
+gap> cov := First(Coverage(), x -> EndsWith(x[1], "testcode1.g"));;
+gap> IsSubset(cov[2], [5, 6, 7]);
+true
+gap> IsSortedList(cov[2]);
+true
+gap> file := Filename(DirectoryTemporary(), "coverage.info");;
+gap> WriteLcov(file) >= 1;
+true
+gap> lcov := StringFile(file);;
+gap> PositionSublist(lcov, "testcode1.g\nDA:") <> fail;
+true
+gap> PositionSublist(lcov, "DA:5,1\n") <> fail;
+true
+gap> PositionSublist(lcov, "end_of_record\n") <> fail;
+true
+gap> ClearCoverage();
+gap> Coverage();
+[  ]
+gap> f();
+gap> Coverage();
+[  ]
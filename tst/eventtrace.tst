@@ -0,0 +1,31 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode2.g");
+gap> ClearEventTrace();
+gap> StartEventTrace(); f(); StopEventTrace();
+gap> ev := DrainEventTrace();;
+gap> List(ev, e -> [e[1], e[3]]) =
+> [ [ 2, 7 ], [ 1, 9 ], [ 2, 3 ], [ 1, 4 ], [ 3, 3 ], [ 1, 10 ], [ 2, 3 ],
+>   [ 1, 4 ], [ 3, 3 ], [ 1, 11 ], [ 2, 3 ], [ 1, 4 ], [ 3, 3 ], [ 3, 7 ] ];
+true
+gap> funcs := EventTraceFunctions();;
+gap> List(ev, e -> Position([f, g], funcs[e[4]])) =
+> [ 1, 1, 2, 2, 2, 1, 2, 2, 2, 1, 2, 2, 2, 1 ];
+true
+gap> ForAll([2..Length(ev)], i -> ev[i][5] >= ev[i-1][5]);
+true
+gap> DrainEventTrace();
+[  ]
+gap> StartEventTrace(4); f(); StopEventTrace();
+gap> List(DrainEventTrace(2), e -> e[1]);
+[ 2, 1 ]
+gap> List(DrainEventTrace(), e -> e[1]);
+[ 3, 3 ]
+gap> StartEventTrace(0);
+Error, Usage: StartEventTrace([size]), where size is a positive integer
+gap> ClearEventTrace();
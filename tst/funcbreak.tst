@@ -0,0 +1,33 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode2.g");
+gap> AddFunctionBreakpoint(g, function(func) Print("g:", gvar2, "\n"); end);
+gap> f();
+g:mark
+g:A
+g:B
+gap> AddFunctionBreakpoint(f, function(func) Print("f\n"); end);
+gap> ListFunctionBreakpoints() = [g, f];
+true
+gap> f();
+f
+g:C
+g:A
+g:B
+gap> ClearFunctionBreakpoint(g);
+true
+gap> ClearFunctionBreakpoint(g);
+false
+gap> f();
+f
+gap> ClearAllBreakpoints();
+gap> ListFunctionBreakpoints();
+[  ]
+gap> f();
+gap> AddFunctionBreakpoint(f, 2);
+Error, Usage: AddFunctionBreakpoint(func[, callback])
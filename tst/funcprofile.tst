@@ -0,0 +1,30 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode2.g");
+gap> ClearFunctionProfile();
+gap> StartFunctionProfile(); f(); StopFunctionProfile();
+gap> prof := FunctionProfile();;
+gap> Length(prof);
+2
+gap> rf := First(prof, r -> IsIdenticalObj(r.func, f));;
+gap> rg := First(prof, r -> IsIdenticalObj(r.func, g));;
+gap> [rf.calls, rg.calls];
+[ 1, 3 ]
+gap> rf.inclusive.max >= rf.self.max;
+true
+gap> rg.inclusive.p50 <= rg.inclusive.p99 and rg.inclusive.p99 <= rg.inclusive.max;
+true
+gap> fib := function(n) if n < 2 then return n; fi; return fib(n-1) + fib(n-2); end;;
+gap> ClearFunctionProfile();
+gap> StartFunctionProfile(); fib(5);; StopFunctionProfile();
+gap> prof := FunctionProfile();;
+gap> [prof[1].calls, prof[1].self.count, prof[1].inclusive.count];
+[ 15, 15, 1 ]
+gap> ClearFunctionProfile();
+gap> FunctionProfile();
+[  ]
@@ -0,0 +1,26 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode5.g");
+gap> grew := fail;;
+gap> BreakOnHeapGrowth(10^6, function(file, line, bytes, stack)
+>   grew := rec(file := file, line := line, bytes := bytes, stack := stack);
+> end);
+gap> l := alloc(2 * 10^6);;
+gap> EndsWith(GET_FILENAME_CACHE()[grew.file], "testcode5.g");
+true
+gap> grew.bytes > 10^6;
+true
+gap> grew.stack[1] = alloc;
+true
+gap> l := 0;; grew := fail;;
+gap> alloc(10);;
+gap> grew;
+fail
+gap> BreakOnHeapGrowth(10^9, fail);
+gap> BreakOnHeapGrowth(0);
+Error, Usage: BreakOnHeapGrowth(bytes[, callback])
@@ -0,0 +1,87 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode3.g");
+gap> Read("testcode5.g");
+gap> AddBreakpoint("testcode3.g", 7, rec(capture := ["i", "total"], history := 3));
+Adding breakpoint to testcode3.g:7
+gap> loopf(10);
+55
+gap> List(BreakpointHistory("testcode3.g", 7),
+>         h -> [h.hit, h.values.i, h.values.total]);
+[ [ 8, 8, 28 ], [ 9, 9, 36 ], [ 10, 10, 45 ] ]
+gap> ClearAllBreakpoints();
+gap> BreakpointHistory("testcode3.g", 7);
+[  ]
+gap> AddBreakpoint("testcode3.g", 7,
+>                  rec(capture := ["i", "unknown"], every := 4));
+Adding breakpoint to testcode3.g:7
+gap> loopf(10);
+55
+gap> List(BreakpointHistory("testcode3.g", 7),
+>         h -> [h.hit, h.values.i, IsBound(h.values.unknown)]);
+[ [ 4, 4, false ], [ 8, 8, false ] ]
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode5.g", 6, rec(capture := ["l"]));
+Adding breakpoint to testcode5.g:6
+gap> alloc(3);;
+gap> List(BreakpointHistory("testcode5.g", 6), h -> Length(h.values.l));
+[ 1, 2, 3 ]
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode5.g", 6, rec(capture := ["l"], copy := "reference"));
+Adding breakpoint to testcode5.g:6
+gap> alloc(3);;
+gap> List(BreakpointHistory("testcode5.g", 6), h -> Length(h.values.l));
+[ 3, 3, 3 ]
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode5.g", 6, rec(capture := ["l", "i"], copy := "summary"));
+Adding breakpoint to testcode5.g:6
+gap> alloc(2);;
+gap> List(BreakpointHistory("testcode5.g", 6), h -> [IsString(h.values.l), h.values.i]);
+[ [ true, 1 ], [ true, 2 ] ]
+gap> AddBreakpoint("testcode5.g", 6, rec(capture := ["l"], copy := "deep"));
+Error, Breakpoint option 'copy' must be "reference", "shallow" or "summary"
+gap> ClearAllBreakpoints();
+gap> AddBreakpoints([["testcode5.g", 6, rec(capture := ["l"], history := 2^19)],
+>                    ["testcode5.g", 6, rec(capture := ["l"], copy := "deep")]]);
+Error, Breakpoint option 'copy' must be "reference", "shallow" or "summary"
+gap> AddBreakpoint("testcode5.g", 6, rec(capture := ["l"], history := 2^19));
+Adding breakpoint to testcode5.g:6
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode3.g", 7, rec(capture := ["i"], history := 2, copy := "reference"));
+Adding breakpoint to testcode3.g:7
+gap> savefile := Filename(DirectoryTemporary(), "breakpoints.txt");;
+gap> SaveBreakpoints(savefile);
+1
+gap> ClearAllBreakpoints();
+gap> LoadBreakpoints(savefile);
+1
+gap> loopf(3);
+6
+gap> List(BreakpointHistory("testcode3.g", 7), h -> h.values.i);
+[ 2, 3 ]
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode3.g", 7, rec(capture := ["i"], history := 2^19 + 1));
+Error, Breakpoint option 'history' must be at most 524288
+gap> AddBreakpoint("testcode3.g", 7, rec(capture := ["i"], copyLimit := 2^30));
+Error, Breakpoint option 'copyLimit' must be at most 67108864
+gap> AddBreakpoint("testcode3.g", 7, rec(capture := ["i", "total"], history := 2^19));
+Error, Breakpoint histories would use too much memory
+gap> AddBreakpoint("testcode5.g", 11, rec(capture := ["x"], history := 2, copy := "reference"));
+Adding breakpoint to testcode5.g:11
+gap> big := List([1, 2], i -> ListWithIdenticalEntries(5 * 10^6, i));;
+gap> keepvalue(big[1]);; keepvalue(big[2]);;
+gap> List(BreakpointHistory("testcode5.g", 11), h -> IsString(h.values.x));
+[ false, true ]
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode5.g", 11, rec(capture := ["x"], history := 2, copy := "reference"));
+Adding breakpoint to testcode5.g:11
+gap> keepvalue(big[2]);; keepvalue(1);; keepvalue(big[1]);;
+gap> List(BreakpointHistory("testcode5.g", 11), h -> IsString(h.values.x));
+[ false, false ]
+gap> Unbind(big);
+gap> ClearAllBreakpoints();
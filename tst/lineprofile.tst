@@ -0,0 +1,22 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode1.g");
+gap> ClearLineProfile();
+gap> StartLineProfile(); f(); f(); StopLineProfile();
+gap> prof := LineProfile();;
+gap> pos := Filtered([1..Length(prof.file)], i -> EndsWith(prof.file[i], "testcode1.g"));;
+gap> List(pos, i -> [prof.line[i], prof.hits[i]]);
+[ [ 5, 2 ], [ 6, 2 ], [ 7, 2 ] ]
+gap> ForAll(prof.time, t -> IsInt(t) and t >= 0);
+true
+gap> f();
+gap> LineProfile().hits = prof.hits;
+true
+gap> ClearLineProfile();
+gap> LineProfile().file;
+[  ]
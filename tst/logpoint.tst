@@ -0,0 +1,66 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode2.g");
+gap> Read("testcode3.g");
+gap> AddLogpoint("testcode2.g", 4, "g: a={a} gvar2={gvar2}");
+Adding logpoint to testcode2.g:4
+gap> f();
+gap> DrainLogpoints();
+[ "g: a=A gvar2=mark", "g: a=B gvar2=A", "g: a=C gvar2=B" ]
+gap> DrainLogpoints();
+[  ]
+gap> AddLogpoint("testcode3.g", 7, "{{i}}={i} total={total} {missing} {l}");
+Adding logpoint to testcode3.g:7
+gap> l := [1, 2];;
+gap> loopf(3);
+6
+gap> FlushLogpoints();
+3
+gap> msgs := DrainLogpoints();;
+gap> msgs[1];
+"{i}=1 total=0 <unbound> [ 1, 2 ]"
+gap> msgs[3];
+"{i}=3 total=3 <unbound> [ 1, 2 ]"
+gap> ClearLogpoints();
+gap> AddLogpoint("testcode3.g", 7, "total={total}");
+Adding logpoint to testcode3.g:7
+gap> logfile := Filename(DirectoryTemporary(), "log.txt");;
+gap> SetLogpointFile(logfile);
+gap> loopf(2);
+3
+gap> SetLogpointFile(fail);
+gap> ReadAll(InputTextFile(logfile));
+"total=0\ntotal=1\n"
+gap> DrainLogpoints();
+[  ]
+gap> AddLogpoint("testcode3.g", 7, "{total");
+Error, Logpoint template has an unclosed '{'
+gap> Read("testcode5.g");
+gap> AddLogpoint("testcode5.g", 5, "l={l}");
+Adding logpoint to testcode5.g:5
+gap> alloc(3);;
+gap> DrainLogpoints();
+[ "l=[  ]", "l=[ [ 0, 1 ] ]", "l=[ [ 0, 1 ], [ 0, 2 ] ]" ]
+gap> AddLogpoint("testcode5.g", 11, "{x}");
+Adding logpoint to testcode5.g:11
+gap> keepvalue(ListWithIdenticalEntries(10^5, 0));;
+gap> keepvalue(Immutable(ListWithIdenticalEntries(3, 0)));;
+gap> msgs := DrainLogpoints();;
+gap> [StartsWith(msgs[1], "<"), EndsWith(msgs[1], " bytes>"), msgs[2]];
+[ true, true, "[ 0, 0, 0 ]" ]
+gap> AddLogpoint("testcode3.g", 14, "n={n}");
+Adding logpoint to testcode3.g:14
+gap> onelinef(3);
+6
+gap> onelinef(2);
+3
+gap> DrainLogpoints();
+[ "n=3", "n=2" ]
+gap> ClearLogpoints();
+gap> ListLogpoints();
+[  ]
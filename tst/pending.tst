@@ -0,0 +1,50 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode4.g", 7, function() Print("7\n"); end, rec(ignore := 1));
+Adding pending breakpoint to testcode4.g:7
+gap> AddBreakpoint("testcode4.g", 10, function() Print("10\n"); end);
+Adding pending breakpoint to testcode4.g:10
+gap> ListPendingBreakpoints();
+[ [ "testcode4.g", 7 ], [ "testcode4.g", 10 ] ]
+gap> ClearBreakpoint("testcode4.g", 10);
+Removing pending breakpoint from testcode4.g:10
+gap> ListPendingBreakpoints();
+[ [ "testcode4.g", 7 ] ]
+gap> Read("testcode4.g");
+gap> ListPendingBreakpoints();
+[ [ "testcode4.g", 7 ] ]
+gap> h(3);
+7
+7
+6
+gap> ListPendingBreakpoints();
+[  ]
+gap> List(ListBreakpoints(), x -> x[2]);
+[ 7 ]
+gap> ClearBreakpoint("testcode4.g", 7);
+Removing breakpoint from testcode4.g:7
+gap> h(3);
+6
+gap> AddBreakpoint("testcode4.g", 10, function() Print("10\n"); end);
+Adding breakpoint to testcode4.g:10
+gap> h(3);
+10
+6
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode6.g", 7, function() Print("k7\n"); end);
+Adding pending breakpoint to testcode6.g:7
+gap> Read("testcode6.g");
+gap> AddBreakpoint("testcode4.g", 7, function() Print("7\n"); end);
+Adding breakpoint to testcode4.g:7
+gap> ListPendingBreakpoints();
+[  ]
+gap> k(2);
+k7
+k7
+3
+gap> ClearAllBreakpoints();
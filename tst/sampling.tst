@@ -0,0 +1,18 @@
+gap> LoadPackage("debugger", false);
+true
+gap> ClearAllBreakpoints();
+gap> ClearSampleProfile();
+gap> spin := function(n) local i, x; x := 0; for i in [1..n] do x := x + i; od; return x; end;;
+gap> StartSampleProfile(100); spin(1000000);; StopSampleProfile();
+gap> folded := SampleProfileFolded();;
+gap> IsString(folded) and folded <> "";
+true
+gap> PositionSublist(folded, "spin") <> fail;
+true
+gap> ForAll(SplitString(folded, "\n"), l -> IsPosInt(Int(SplitString(l, " ")[Length(SplitString(l, " "))])));
+true
+gap> StartSampleProfile(0);
+Error, Usage: StartSampleProfile([interval])
+gap> ClearSampleProfile();
+gap> SampleProfileFolded();
+""
@@ -0,0 +1,47 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode2.g");
+gap> ShadowBacktrace();
+fail
+gap> StartShadowStack();
+gap> ShadowBacktrace();
+[  ]
+gap> LastBreakpointBacktrace();
+fail
+gap> AddBreakpoint("testcode2.g", 4,
+>     function() bt := ShadowBacktrace(); ClearAllBreakpoints(); end,
+>     rec(ignore := 1));
+Adding breakpoint to testcode2.g:4
+gap> f();
+gap> List(bt, r -> r.line);
+[ 4, 10 ]
+gap> bt[1].func = g and bt[2].func = f;
+true
+gap> EndsWith(bt[1].file, "testcode2.g");
+true
+gap> ForAll(bt, r -> IsInt(r.time) and r.time >= 0);
+true
+gap> List(LastBreakpointBacktrace(), r -> r.line);
+[ 4, 10 ]
+gap> ClearAllBreakpoints();
+gap> ShadowBacktrace();
+[  ]
+gap> recurse := function(n) if n > 0 then recurse(n - 1); fi; end;;
+gap> recurse(5);
+gap> First(RecursionDepths(), r -> r.func = recurse).depth;
+6
+gap> First(RecursionDepths(), r -> r.func = f).depth;
+1
+gap> fails := function(n) if n = 0 then Error("oops"); fi; fails(n - 1); end;;
+gap> fails(3);
+Error, oops
+gap> ShadowBacktrace();
+[  ]
+gap> StopShadowStack();
+gap> ShadowBacktrace();
+fail
@@ -0,0 +1,25 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode1.g");
+gap> file := Filename(DirectoryTemporary(), "shared.prof");;
+gap> StartSharedProfile(file); f(); f(); StopSharedProfile();
+gap> prof := ReadSharedProfile(file);;
+gap> pos := Filtered([1..Length(prof.lines.file)], i -> EndsWith(prof.lines.file[i], "testcode1.g"));;
+gap> Set(pos, i -> [prof.lines.line[i], prof.lines.hits[i]]);
+[ [ 5, 2 ], [ 6, 2 ], [ 7, 2 ] ]
+gap> List(Filtered(prof.functions, r -> EndsWith(r.file, "testcode1.g")), r -> [r.line, r.calls]);
+[ [ 3, 2 ] ]
+gap> prof.dropped;
+0
+gap> StartSharedProfile(file); f(); StopSharedProfile();
+gap> prof := ReadSharedProfile(file);;
+gap> pos := Filtered([1..Length(prof.lines.file)], i -> EndsWith(prof.lines.file[i], "testcode1.g"));;
+gap> Set(pos, i -> [prof.lines.line[i], prof.lines.hits[i]]);
+[ [ 5, 3 ], [ 6, 3 ], [ 7, 3 ] ]
+gap> ReadSharedProfile("testcode1.g");
+Error, 'testcode1.g' is not a shared profile
@@ -0,0 +1,47 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> h := function(n, flag)
+>   local x, unset;
+>   x := n + 1;
+>   ShowLocals();
+> end;;
+gap> h(5, true);
+Function with 2 arguments
+ n: 5 (integer)
+ flag: true (boolean or fail)
+Local variables:
+ x: 6 (integer)
+ unset: <unbound>
+gap> k := function()
+>   local l, r;
+>   l := List([1..100], i -> i^2);
+>   r := rec(gens := [[1, 2], [3, 4]]);
+>   ShowLocal("l", 7);
+>   ShowLocal("l", [5..7], 2);
+>   ShowLocal("r", "gens", 2, 1);
+>   ShowLocal("unknown");
+> end;;
+gap> k();
+49 (integer)
+36 (integer)
+3 (integer)
+Error, No local variable 'unknown'
+gap> big := List([1..1000], i -> [i]);;
+gap> StartsWith(DESCRIBE_VALUE(big, 1000, 3),
+>              "[ [ 1 ], [ 2 ], [ 3 ], ... (1000 elements) ] (");
+true
+gap> StartsWith(DESCRIBE_VALUE(rec(sizes := [1, 2]), 1000, 10),
+>              "rec( sizes := [ 1, 2 ] ) (");
+true
+gap> StartsWith(DESCRIBE_VALUE(ListWithIdenticalEntries(100, 'a'), 10, 10),
+>              "\"aaaaaaaaa\" (100 characters) (");
+true
+gap> StartsWith(DESCRIBE_VALUE(SymmetricGroup(5), 10, 10), "<");
+true
+gap> ShowLocals();
+Error, ShowLocals must be run from break loop or a function
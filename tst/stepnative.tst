@@ -0,0 +1,50 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode2.g");
+gap> stepped := function(name) return function(file, line) Print(name, ":", line, "\n"); end; end;;
+gap> AddBreakpoint("testcode2.g", 9, function() StepOver(stepped("over")); end);
+Adding breakpoint to testcode2.g:9
+gap> f();
+over:10
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode2.g", 4,
+>     function() ClearAllBreakpoints(); StepOut(stepped("out")); end,
+>     rec(ignore := 1));
+Adding breakpoint to testcode2.g:4
+gap> f();
+out:11
+gap> ClearAllBreakpoints();
+gap> AddBreakpoint("testcode2.g", 9, function() StepLines(3, stepped("lines")); end);
+Adding breakpoint to testcode2.g:9
+gap> f();
+lines:4
+gap> ClearAllBreakpoints();
+gap> StepOver(fail);
+gap> f();
+gap> StepLines(0);
+Error, Usage: StepLines(n[, func]), where n is a positive integer
+gap> ClearAllBreakpoints();
+gap> oldBreakOnError := BreakOnError;; BreakOnError := true;;
+gap> oldOnBreak := OnBreak;; OnBreak := function() end;;
+gap> oldOnBreakMessage := OnBreakMessage;; OnBreakMessage := function() end;;
+gap> AddBreakpoint("testcode2.g", 9, function() Error("stop"); end);
+Adding breakpoint to testcode2.g:9
+gap> f();
+Error, stop
+brk> ClearAllBreakpoints(); StepOver(stepped("over"));
+brk> return;
+over:10
+gap> AddBreakpoint("testcode2.g", 4, function() Error("stop"); end);
+Adding breakpoint to testcode2.g:4
+gap> f();
+Error, stop
+brk> ClearAllBreakpoints(); StepOut(stepped("out"));
+brk> return;
+out:10
+gap> OnBreak := oldOnBreak;; OnBreakMessage := oldOnBreakMessage;;
+gap> BreakOnError := oldBreakOnError;;
@@ -0,0 +1,15 @@
+gcount := 0;
+
+loopf := function(n)
+    local i, total;
+    total := 0;
+    for i in [1..n] do
+        total := total + i;
+        gcount := gcount + 1;
+    od;
+    return total;
+end;
+
+onelinef := function(n)
+    local i, total; total := 0; for i in [1..n] do total := total + i; od; return total;
+end;
@@ -0,0 +1,13 @@
+# This file is only read by pending.tst, so it has not been read
+# before breakpoints are added.
+h := function(n)
+    local i, total;
+    total := 0;
+    for i in [1..n] do
+        total := total + i;
+        hcount := hcount + 1;
+    od;
+    return total;
+end;
+
+hcount := 0;
@@ -0,0 +1,12 @@
+alloc := function(n)
+    local l, i;
+    l := [];
+    for i in [1..n] do
+        Add(l, [i, i]);
+        l[i][1] := 0;
+    od;
+    return l;
+end;
+keepvalue := function(x)
+    return x;
+end;
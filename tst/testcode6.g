@@ -0,0 +1,10 @@
+# This file is only read by pending.tst, after a pending breakpoint on it
+# is added.
+k := function(n)
+    local i, total;
+    total := 0;
+    for i in [1..n] do
+        total := total + i;
+    od;
+    return total;
+end;
@@ -0,0 +1,47 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode2.g");
+gap> tracefile := Filename(DirectoryTemporary(), "trace.bin");;
+gap> StartTraceFile(tracefile); f(); StopTraceFile() > 0;
+true
+gap> StopTraceFile();
+fail
+gap> ev := [];;
+gap> ReadTraceFile(tracefile, function(l) Add(ev, l); end, 5);
+gap> List(ev, Length);
+[ 5, 5, 4 ]
+gap> ev := Concatenation(ev);;
+gap> List(ev, e -> [e[1], e[3]]) =
+> [ [ 2, 7 ], [ 1, 9 ], [ 2, 3 ], [ 1, 4 ], [ 3, 3 ], [ 1, 10 ], [ 2, 3 ],
+>   [ 1, 4 ], [ 3, 3 ], [ 1, 11 ], [ 2, 3 ], [ 1, 4 ], [ 3, 3 ], [ 3, 7 ] ];
+true
+gap> ForAll(ev, e -> EndsWith(e[2], "testcode2.g"));
+true
+gap> ForAll([2..Length(ev)], i -> ev[i][4] >= ev[i-1][4]);
+true
+gap> s := TraceFileSummary(tracefile);;
+gap> [s.statements, s.calls, s.complete];
+[ 6, 4, true ]
+gap> s.lines.line;
+[ 4, 9, 10, 11 ]
+gap> s.lines.hits;
+[ 3, 1, 1, 1 ]
+gap> ReadTraceFile(tracefile, Length, 0);
+Error, Usage: ReadTraceFile(filename, func[, chunk])
+gap> badfile := Filename(DirectoryTemporary(), "bad.bin");;
+gap> FileString(badfile, Concatenation("GAPTRC01", List(
+>     [1, 255, 255, 255, 255, 15, 1, 65, 2, 255, 255, 255, 255, 15, 3, 10, 0],
+>     CHAR_INT)));;
+gap> s := TraceFileSummary(badfile);;
+gap> [s.statements, s.lines.file, s.lines.line, s.complete];
+[ 1, [ "A" ], [ 5 ], true ]
+gap> FileString(badfile, Concatenation("GAPTRC01", List([2, 7, 3, 10, 0], CHAR_INT)));;
+gap> TraceFileSummary(badfile).complete;
+false
+gap> ReadTraceFile(badfile, Length);
+Error, Trace file is truncated or corrupt
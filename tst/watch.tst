@@ -0,0 +1,40 @@
+gap> LoadPackage("debugger", false);
+true
+gap> LoadPackage("io", false);
+true
+gap> IO_chdir(Filename(DirectoriesPackageLibrary("debugger", "tst")[1],""));
+true
+gap> ClearAllBreakpoints();
+gap> Read("testcode2.g");
+gap> show := function(name, old, new, file, line)
+>   Print(name, ": ", old, " -> ", new, " at line ", line, "\n");
+> end;;
+gap> WatchGlobal("gvar2", show);
+gap> WatchedGlobals();
+[ "gvar2" ]
+gap> f();
+gvar2: mark -> A at line 4
+gvar2: A -> B at line 4
+gvar2: B -> C at line 4
+gap> f();
+gvar2: C -> A at line 4
+gvar2: A -> B at line 4
+gvar2: B -> C at line 4
+gap> wl := [];;
+gap> WatchGlobal("wl", function(name, old, new, file, line)
+>   Print(name, ": ", new, " ", IsIdenticalObj(old, new), "\n"); end);
+gap> addw := function(x) Add(wl, x); end;;
+gap> addw(1); addw(2);
+wl: [ 1 ] true
+wl: [ 1, 2 ] true
+gap> UnwatchGlobal("gvar2");
+true
+gap> UnwatchGlobal("gvar2");
+false
+gap> f(); addw(3);
+wl: [ 1, 2, 3 ] true
+gap> UnwatchGlobal("wl");
+true
+gap> WatchedGlobals();
+[  ]
+gap> f();